@@ -0,0 +1,43 @@
+# Generates a header holding every shader source as a constexpr string table
+# Run in script mode: cmake -DSHADER_DIR=<shaders> -DOUTPUT=<header> -P EmbedShaders.cmake
+
+file(GLOB SHADER_FILES RELATIVE "${SHADER_DIR}" "${SHADER_DIR}/*.vert" "${SHADER_DIR}/*.frag" "${SHADER_DIR}/*.glsl")
+list(SORT SHADER_FILES)
+
+# MSVC caps a single string literal at 16KB, so long sources are emitted as adjacent literals
+set(CHUNK_SIZE 8000)
+
+set(HEADER "// Generated by cmake/EmbedShaders.cmake from the shaders directory, do not edit\n")
+string(APPEND HEADER "#ifndef OBEMBEDDEDSHADERS_H\n#define OBEMBEDDEDSHADERS_H\n\n")
+string(APPEND HEADER "#include <string_view>\n\n")
+string(APPEND HEADER "struct EmbeddedShader {\n    std::string_view name;\n    std::string_view source;\n};\n\n")
+string(APPEND HEADER "inline constexpr EmbeddedShader EMBEDDED_SHADERS[] = {\n")
+
+foreach(SHADER_FILE IN LISTS SHADER_FILES)
+    file(READ "${SHADER_DIR}/${SHADER_FILE}" SOURCE)
+    string(LENGTH "${SOURCE}" SOURCE_LENGTH)
+    string(APPEND HEADER "    {\"/${SHADER_FILE}\",\n")
+    if (SOURCE_LENGTH EQUAL 0)
+        string(APPEND HEADER "        \"\"")
+    endif()
+    set(OFFSET 0)
+    while (OFFSET LESS SOURCE_LENGTH)
+        string(SUBSTRING "${SOURCE}" ${OFFSET} ${CHUNK_SIZE} CHUNK)
+        string(APPEND HEADER "        R\"obshader(${CHUNK})obshader\"")
+        math(EXPR OFFSET "${OFFSET} + ${CHUNK_SIZE}")
+        if (OFFSET LESS SOURCE_LENGTH)
+            string(APPEND HEADER "\n")
+        endif()
+    endwhile()
+    string(APPEND HEADER "},\n")
+endforeach()
+
+string(APPEND HEADER "};\n\n#endif\n")
+
+# Only touch the header when it changes, so unrelated rebuilds stay incremental
+if (EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" PREVIOUS)
+endif()
+if (NOT "${PREVIOUS}" STREQUAL "${HEADER}")
+    file(WRITE "${OUTPUT}" "${HEADER}")
+endif()
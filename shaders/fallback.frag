@@ -0,0 +1,7 @@
+#version 410 core
+out vec4 FragColor;
+
+// Flat placeholder drawn while an object's real program is still compiling
+void main() {
+    FragColor = vec4(0.5, 0.5, 0.5, 1.0);
+}
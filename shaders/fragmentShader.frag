@@ -1,8 +1,8 @@
-#version 330 core
+#version 410 core
 out vec4 FragColor;
 
-in vec2 TexCoord;
-in vec3 colorVal;
+layout (location = 0) in vec2 TexCoord;
+layout (location = 1) in vec3 colorVal;
 
 uniform sampler2D texture1;
 uniform sampler2D texture2;
@@ -0,0 +1,8 @@
+// Per-frame data shared by every program, filled once per frame by FrameUniforms (obFrameUniforms.h)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 viewPos; // w is unused
+    float time;
+} frame;
@@ -0,0 +1,39 @@
+// Phong lighting shared by lit fragment shaders
+// Define HAS_SPECULAR to include the specular term
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+struct Light {
+    vec3 position;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// Light contribution at a world space fragment, albedo replaces material.diffuse (e.g. when textured)
+vec3 shadeLight(Light light, Material material, vec3 albedo, vec3 norm, vec3 viewDir, vec3 fragPos) {
+    // Ambient
+    vec3 ambient = light.ambient * material.ambient;
+
+    // Diffuse
+    vec3 lightDir = normalize(light.position - fragPos);
+    // Get difference between the fragment's normal and the direction of the light
+    // Use max for cases where dot is negative due to a difference greater than 90 degrees.
+    float diff = max(dot(norm, lightDir), 0.0); 
+    vec3 diffuse = light.diffuse * (diff * albedo);
+
+#ifdef HAS_SPECULAR
+    // Specular
+    // reflect expects the first vector to point from the light source
+    vec3 reflectDir = reflect(-lightDir, norm); 
+    float spec = pow(max(dot(viewDir, reflectDir), 0.00001), material.shininess);
+    vec3 specular = light.specular * (spec * material.specular);
+    return ambient + diffuse + specular;
+#else
+    return ambient + diffuse;
+#endif
+}
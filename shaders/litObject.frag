@@ -1,46 +1,48 @@
-#version 330 core
-struct Material {
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float shininess;
-};
-
-struct Light {
-    vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+#version 410 core
+// Permutations: HAS_SPECULAR, TEXTURED, INSTANCED, NUM_LIGHTS (see ShaderPermutations)
+#include "frame.glsl"
+#include "materials.glsl"
+
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS 1
+#endif
 
 out vec4 FragColor;
 
-in vec3 Normal;
-in vec3 FragPos;
+layout (location = 0) in vec3 Normal;
+layout (location = 1) in vec3 FragPos;
 
-uniform vec3 viewPos;
-uniform Material material;
-uniform Light light;
+uniform Light lights[NUM_LIGHTS];
 
-void main() {
-    // Ambient
-    vec3 ambient = light.ambient * material.ambient;
+#ifdef INSTANCED
+layout (location = 3) flat in uint MaterialID;
+#else
+uniform int materialID;
+#endif
 
-    // Diffuse
+#ifdef TEXTURED
+layout (location = 2) in vec2 TexCoord;
+uniform sampler2D diffuseMap;
+#endif
+
+void main() {
+#ifdef INSTANCED
+    Material material = materials[MaterialID];
+#else
+    Material material = materials[materialID];
+#endif
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(light.position - FragPos);
-    // Get difference between the fragment's normal and the direction of the light
-    // Use max for cases where dot is negative due to a difference greater than 90 degrees.
-    float diff = max(dot(norm, lightDir), 0.0); 
-    vec3 diffuse = light.diffuse * (diff * material.diffuse);
-
-    // Specular
-    vec3 viewDir = normalize(viewPos - FragPos);
-    // reflect expects the first vector to point from the light source
-    vec3 reflectDir = reflect(-lightDir, norm); 
-    float spec = pow(max(dot(viewDir, reflectDir), 0.00001), material.shininess); // use 32 as highlight shininess
-    vec3 specular = light.specular * (spec * material.specular);
-
-    vec3 result = ambient + diffuse + specular;
+    vec3 viewDir = normalize(frame.viewPos.xyz - FragPos);
+
+    vec3 albedo = material.diffuse;
+#ifdef TEXTURED
+    albedo *= texture(diffuseMap, TexCoord).rgb;
+#endif
+
+    // The loop has a constant trip count, so each variant is fully unrolled
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < NUM_LIGHTS; i++) {
+        result += shadeLight(lights[i], material, albedo, norm, viewDir, FragPos);
+    }
     FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
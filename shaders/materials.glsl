@@ -0,0 +1,9 @@
+// Every material in the scene, filled by MaterialTable (obMaterials.h)
+#include "lighting.glsl"
+
+// Must match MaterialTable::MAX_MATERIALS
+#define MAX_MATERIALS 256
+
+layout (std140) uniform MaterialData {
+    Material materials[MAX_MATERIALS];
+};
@@ -0,0 +1,31 @@
+// Transforms shared by every vertex shader
+#include "frame.glsl"
+
+// Stages are linked as separable programs, which have to redeclare the built-in outputs they write
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+#ifdef INSTANCED
+// Instanced draws read the model matrix and material per instance (see InstanceBuffer)
+// The matrix takes locations 3 to 6, one per column
+layout (location = 3) in mat4 instanceModel;
+layout (location = 7) in uint instanceMaterialID;
+
+mat4 modelMatrix() {
+    return instanceModel;
+}
+#else
+uniform mat4 model;
+
+mat4 modelMatrix() {
+    return model;
+}
+#endif
+
+// Read multiplication from right to left
+// Camera is responsible for handling view and projection matrices
+// Each object is responsible for the model matrix (transforming local to world space)
+vec4 toClipSpace(vec3 position) {
+    return frame.viewProjection * modelMatrix() * vec4(position, 1.0);
+}
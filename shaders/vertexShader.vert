@@ -1,20 +1,15 @@
-#version 330 core
+#version 410 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
 
-out vec2 TexCoord;
-out vec3 colorVal;
+layout (location = 0) out vec2 TexCoord;
+layout (location = 1) out vec3 colorVal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "transform.glsl"
 
 void main() {
-    // Read multiplication from right to left
-    // Camera is responsible for handling view and projection matrices
-    // Each object is responsible for the model matrix (transforming local to world space)
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = toClipSpace(aPos);
     colorVal = aColor;
     TexCoord = aTexCoord;
 }
@@ -9,10 +9,37 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "obShader.h"
+#include "obShaderCompiler.h"
+#include "obShaderPermutations.h"
+#include "obShaderSource.h"
+#include "obShaderWatcher.h"
 #include "obCamera.h"
-
+#include "obDynamicResolution.h"
+#include "obFixedTimestep.h"
+#include "obFrameUniforms.h"
+#include "obGLState.h"
+#include "obGpuProfiler.h"
+#include "obHeadless.h"
+#include "obIndirectRenderer.h"
+#include "obInput.h"
+#include "obInstances.h"
+#include "obMaterials.h"
+#include "obMeshBuilder.h"
+#include "obRenderQueue.h"
+#include "obTransforms.h"
+#include "obViewSet.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 #ifndef IS_MACOS
 // Khronos debug function converted to C++ (see https://www.khronos.org/opengl/wiki/OpenGL_Error)
@@ -28,7 +55,33 @@ void GLAPIENTRY MessageCallback(GLenum source,
 }
 #endif
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --benchmark-transforms [count] times the batch transform kernels against glm and exits
+    if (argc >= 2 && std::strcmp(argv[1], "--benchmark-transforms") == 0) {
+        // Every kernel works on a few arrays of count matrices, so keep them to a few hundred MB
+        const unsigned long MAX_COUNT = 1ul << 22;
+        unsigned long count = 100000;
+        if (argc >= 3) {
+            char* end = nullptr;
+            errno = 0;
+            count = std::strtoul(argv[2], &end, 10);
+            if (end == argv[2] || *end != '\0' || errno == ERANGE || argv[2][0] == '-' || count < 1 || count > MAX_COUNT) {
+                std::cerr << "ERROR::TRANSFORMS::BAD_COUNT --> " << argv[2] << std::endl;
+                std::cerr << "Usage: obelisk --benchmark-transforms [count], count from 1 to " << MAX_COUNT << std::endl;
+                return -1;
+            }
+        }
+        benchmarkTransforms(count);
+        return 0;
+    }
+
+    // --headless [options] renders a scripted flight offscreen with no window, see obHeadless.h
+    HeadlessOptions headlessOptions;
+    const bool headless = argc >= 2 && std::strcmp(argv[1], "--headless") == 0;
+    if (headless && !parseHeadlessOptions(argc - 2, argv + 2, headlessOptions)) {
+        return -1;
+    }
+
     // ---------------------
     // Initialization
     // ---------------------
@@ -37,50 +90,78 @@ int main() {
     constexpr int windowWidth = 1920;
     constexpr int windowHeight = 1080;
 
-    // Movement flags
-    char MOVE_FORWARD = 1 << 0; // 1
-    char MOVE_BACKWARD = 1 << 1; // 2
-    char MOVE_LEFT = 1 << 2; // 4
-    char MOVE_RIGHT = 1 << 3; // 8
-
     // OpenGL Context Setup
     sf::ContextSettings contextSettings;
     contextSettings.depthBits = 24;
     contextSettings.stencilBits = 8;
-    contextSettings.antiAliasingLevel = 4;
+    // No multisampling on the window itself, the scene is multisampled offscreen (see DynamicResolution)
+    contextSettings.antiAliasingLevel = 0;
     contextSettings.majorVersion = 4;
     contextSettings.minorVersion = 1;
     contextSettings.attributeFlags = contextSettings.Core;
     contextSettings.sRgbCapable = true;
 
-    // SFML Window Setup
-    sf::Window window(sf::VideoMode({windowWidth, windowHeight}), "Obelisk", sf::Style::Default, sf::State::Windowed, contextSettings);
-    window.setFramerateLimit(144);
-    window.setVerticalSyncEnabled(true);
-    window.setMouseCursorVisible(false);
-    window.setMouseCursorGrabbed(true);
-    if (!window.setActive(true)) {
-        return -1;
-    };
+    // SFML Window Setup, or an offscreen context in its place when headless
+    std::optional<sf::Window> window;
+    std::optional<HeadlessContext> headlessContext;
+    GLADloadproc loader = reinterpret_cast<GLADloadproc>(sf::Context::getFunction);
+    if (headless) {
+        headlessContext.emplace();
+        if (!headlessContext->isValid()) {
+            return -1;
+        }
+        loader = HeadlessContext::getFunction;
+    } else {
+        window.emplace(sf::VideoMode({windowWidth, windowHeight}), "Obelisk", sf::Style::Default, sf::State::Windowed, contextSettings);
+        window->setFramerateLimit(144);
+        window->setVerticalSyncEnabled(true);
+        window->setMouseCursorVisible(false);
+        window->setMouseCursorGrabbed(true);
+        if (!window->setActive(true)) {
+            return -1;
+        };
+    }
 
     // Initialize OpenGL extension loader
-    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(sf::Context::getFunction))) {
+    if (!gladLoadGLLoader(loader)) {
         return -1;
     }
 
+    // Pick how deferred shaders get compiled on this driver
+    initShaderCompiler(loader);
+
+    // Size of what we render into, the window's or the headless framebuffer's
+    const int viewportWidth = headless ? headlessOptions.width : static_cast<int>(window->getSize().x);
+    const int viewportHeight = headless ? headlessOptions.height : static_cast<int>(window->getSize().y);
+
     // Start the SFML clock
     sf::Clock clock;
 
 #ifndef IS_MACOS
     // Enable debug output (see https://www.khronos.org/opengl/wiki/OpenGL_Error)
-    glEnable( GL_DEBUG_OUTPUT );
+    GLState::setEnabled(GL_DEBUG_OUTPUT, true);
     glDebugMessageCallback( MessageCallback, 0 );
 #endif
 
     // GL Setup
-    glEnable(GL_DEPTH_TEST);
+    GLState::setEnabled(GL_DEPTH_TEST, true);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
+    // The scene renders offscreen with 4x MSAA, at a resolution that drops when the GPU can't keep up
+    // with the frame rate, and is upscaled to the window at the end of the frame
+    // Headless runs stay at full resolution, so their frames are reproducible
+    DynamicResolution resolution(viewportWidth, viewportHeight, 4, headless ? 1.0f : 0.5f, 1.0f, 1000.0f / 144.0f);
+    if (headless) {
+        resolution.setOutputFramebuffer(headlessContext->createFramebuffer(viewportWidth, viewportHeight));
+    }
+
+    // GPU time of the frame and of each pass in it, which also drives the resolution scale
+    // Headless runs keep every frame's times for the report at the end
+    GpuProfiler gpuProfiler(headless ? static_cast<std::size_t>(headlessOptions.frames) : 120);
+    const unsigned int FRAME_SCOPE = gpuProfiler.getScope("frame");
+    const unsigned int SCENE_SCOPE = gpuProfiler.getScope("scene");
+    const unsigned int UPSCALE_SCOPE = gpuProfiler.getScope("upscale");
+
     // ---------------------
     // Vertex Data
     // ---------------------
@@ -132,18 +213,32 @@ int main() {
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
     };
 
+    // Weld the shared corners of each face and order the triangles for the vertex cache
+    MeshBuilder cubeMesh(6);
+    cubeMesh.addVertices(vertices, sizeof(vertices) / (6 * sizeof(float)));
+    cubeMesh.optimize();
+    const GLsizei cubeIndexCount = static_cast<GLsizei>(cubeMesh.getIndices().size());
+    std::cout << "Cube mesh: " << cubeMesh.getVertexCount() << " vertices, " << cubeIndexCount / 3
+              << " triangles, ACMR " << cubeMesh.getACMR() << std::endl;
+
     // Create a vertex array object (VAO) to store vertex attribute states
     unsigned int VAO;
     glGenVertexArrays(1, &VAO);
+    GLState::bindVertexArray(VAO);
 
     // Create a vertex buffer object to store the vertex data
     unsigned int VBO;
     glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, cubeMesh.getVertices().size() * sizeof(float), cubeMesh.getVertices().data(), GL_STATIC_DRAW);
+
+    // And an element buffer object for the indices, the VAO remembers it
+    unsigned int EBO;
+    glGenBuffers(1, &EBO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, cubeMesh.getIndices().size() * sizeof(std::uint32_t), cubeMesh.getIndices().data(), GL_STATIC_DRAW);
 
     // Link the vertex attributes
-    glBindVertexArray(VAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -156,15 +251,38 @@ int main() {
 
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
-    glBindVertexArray(lightVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // We can reuse the previous buffer 
+    GLState::bindVertexArray(lightVAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO); // We can reuse the previous buffers
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // A floor of props, every copy of the cube drawn by one instanced call
+    // Their transforms and materials come from an instance buffer instead of uniforms
+    const int PROP_GRID_SIZE = 32;
+    const float PROP_SPACING = 2.0f;
+    const glm::vec3 propGridCenter(0.0f, -4.0f, -4.0f);
+    InstanceBuffer props;
+    unsigned int propVAO;
+    glGenVertexArrays(1, &propVAO);
+    GLState::bindVertexArray(propVAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    props.attach(propVAO);
+
+    // The other way to draw the lit objects, all meshes in shared buffers submitted as one indirect draw
+    IndirectRenderer indirectRenderer;
+    const unsigned int cubeMeshID = indirectRenderer.addMesh(cubeMesh);
+    bool indirectMode = headlessOptions.indirect;
+
     // Create  OpenGL textures
     unsigned int texture1, texture2;
     glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture1);
 
     // ---------------------
     // Textures
@@ -196,7 +314,7 @@ int main() {
 
     // Texture 2
     glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture2);
 
     // Load second image texture
     std::string facePath = std::filesystem::path(TEXTURE_PATH).string() + "/awesomeface.png";
@@ -218,187 +336,476 @@ int main() {
 
     // Camera
     Camera cam = Camera();
+    cam.setViewport(viewportWidth, viewportHeight);
 
-    // Timing
-    float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
+    // Timing, the simulation runs in fixed steps however fast frames are rendered
+    FixedTimestep timestep(1.0f / 144.0f);
+    sf::Clock frameClock;
 
     // Model matrix that we'll modify for each cube
     glm::mat4 model = glm::mat4(1.0f);
 
+    // Bounds of everything in the scene, only what the camera can see gets drawn
+    enum SCENE_OBJECT {
+        LIGHT_CUBE,
+        LIT_CUBE,
+        PROPS,
+        SCENE_OBJECT_COUNT
+    };
+    const float cubeRadius = 0.5f * std::sqrt(3.0f);
+    BoundingSpheres sceneBounds;
+    sceneBounds.add(lightPos, cubeRadius * 0.2f);
+    sceneBounds.add(glm::vec3(0, -1, -3), cubeRadius);
+    // The props are culled as one group, a single sphere around the whole grid
+    const float propGridExtent = (PROP_GRID_SIZE - 1) * PROP_SPACING * 0.5f;
+    sceneBounds.add(propGridCenter, std::sqrt(2.0f) * propGridExtent + cubeRadius);
+
+    // Every camera that renders the scene, culled together
+    ViewSet views;
+    const std::size_t MAIN_VIEW = views.addView(cam);
+
     // ---------------------
     // Shaders
     // ---------------------
 
-    // Load and compile our shaders
-    Shader litShader("/basic.vert", "/litObject.frag");
-    glm::vec3 lightColor = {1.0f, 0.5f, 0.31f};
-    glm::vec3 objectColor = {1.0f, 1.0f, 1.0f};
-    litShader.use();
-    litShader.setVec3("material.ambient", glm::vec3(1.0f, 0.5f, 0.31f));
-    litShader.setVec3("material.diffuse", glm::vec3(1.0f, 0.5f, 0.31f));
-    litShader.setVec3("material.specular", glm::vec3(0.5f, 0.5f, 0.5f));
-    litShader.setFloat("material.shininess", 32.0f);
-    litShader.setVec3("light.specular", glm::vec3(1.0f, 1.0f, 1.0f));
+    // View, projection and the like are shared by all programs through one uniform buffer
+    FrameUniforms frameUniforms;
+
+    // All materials live in one table, objects refer to theirs by ID
+    MaterialTable materials;
+    unsigned int cubeMaterial = materials.add({
+        glm::vec3(1.0f, 0.5f, 0.31f), // ambient
+        glm::vec3(1.0f, 0.5f, 0.31f), // diffuse
+        glm::vec3(0.5f, 0.5f, 0.5f),  // specular
+        32.0f                         // shininess
+    });
+    unsigned int propMaterial = materials.add({
+        glm::vec3(0.2f, 0.4f, 0.6f),
+        glm::vec3(0.2f, 0.4f, 0.6f),
+        glm::vec3(0.3f, 0.3f, 0.3f),
+        16.0f
+    });
+
+    // Checker the props between the two materials, each slightly rotated
+    // The indirect mode queues them again every frame, so keep them around
+    std::vector<glm::mat4> propModels;
+    std::vector<unsigned int> propMaterials;
+    for (int x = 0; x < PROP_GRID_SIZE; x++) {
+        for (int z = 0; z < PROP_GRID_SIZE; z++) {
+            glm::vec3 offset = glm::vec3(x * PROP_SPACING - propGridExtent, 0.0f, z * PROP_SPACING - propGridExtent);
+            glm::mat4 propModel = glm::translate(glm::mat4(1.0f), propGridCenter + offset);
+            propModel = glm::rotate(propModel, glm::radians(7.0f * (x + z)), glm::vec3(0.0f, 1.0f, 0.0f));
+            props.add(propModel, (x + z) % 2 == 0 ? cubeMaterial : propMaterial);
+            propModels.push_back(propModel);
+            propMaterials.push_back((x + z) % 2 == 0 ? cubeMaterial : propMaterial);
+        }
+    }
+
+    // Pick up edits to the shader sources while running, when they are read from disk
+    ShaderWatcher shaderWatcher(shadersFromDisk() ? shaderDirectory() : "");
+
+    // A cheap program compiled up front, used for anything whose own program isn't ready yet
+    Shader fallbackShader("/basic.vert", "/fallback.frag");
+    shaderWatcher.watch(fallbackShader);
+    UniformHandle fallbackModel;
+    fallbackShader.onReady([&](Shader &shader) {
+        fallbackModel = shader.getUniform("model");
+    });
+
+    // Lit objects get a variant specialized for their features instead of branching per fragment
+    enum LIT_FEATURE {
+        LIT_SPECULAR = 1 << 0,
+        LIT_TEXTURED = 1 << 1,
+        LIT_INSTANCED = 1 << 2
+    };
+    ShaderPermutations litPermutations("/basic.vert", "/litObject.frag", {"HAS_SPECULAR", "TEXTURED", "INSTANCED"}, "NUM_LIGHTS",
+                                       Shader::DEFERRED, &shaderWatcher);
+
+    // Submit our real shaders, they finish compiling while we start rendering
+    // Uniforms are resolved once each program links so the render loop never looks up names
+    Shader &litShader = litPermutations.get(ShaderPermutations::makeKey(LIT_SPECULAR, 1));
+    UniformHandle litModel;
+    UniformHandle litLightPosition;
+    UniformHandle litLightAmbient;
+    UniformHandle litLightDiffuse;
+    UniformHandle litMaterialID;
+    litShader.onReady([&](Shader &shader) {
+        litModel = shader.getUniform("model");
+        litLightPosition = shader.getUniform("lights[0].position");
+        litLightAmbient = shader.getUniform("lights[0].ambient");
+        litLightDiffuse = shader.getUniform("lights[0].diffuse");
+        litMaterialID = shader.getUniform("materialID");
+
+        shader.setVec3("lights[0].specular", glm::vec3(1.0f, 1.0f, 1.0f));
+    });
+
+    // The props read their model and material from the instance buffer
+    Shader &propShader = litPermutations.get(ShaderPermutations::makeKey(LIT_SPECULAR | LIT_INSTANCED, 1));
+    UniformHandle propLightPosition;
+    UniformHandle propLightAmbient;
+    UniformHandle propLightDiffuse;
+    propShader.onReady([&](Shader &shader) {
+        propLightPosition = shader.getUniform("lights[0].position");
+        propLightAmbient = shader.getUniform("lights[0].ambient");
+        propLightDiffuse = shader.getUniform("lights[0].diffuse");
+
+        shader.setVec3("lights[0].specular", glm::vec3(1.0f, 1.0f, 1.0f));
+    });
 
     // For the light source
-    Shader sourceShader("/basic.vert", "/light.frag");
+    Shader sourceShader("/basic.vert", "/light.frag", Shader::DEFERRED);
+    UniformHandle sourceModel;
+    sourceShader.onReady([&](Shader &shader) {
+        sourceModel = shader.getUniform("model");
+    });
+    shaderWatcher.watch(sourceShader);
+
+    // Activate a program and upload the object's model matrix
+    auto useWithModel = [](Shader &shader, UniformHandle modelHandle, const glm::mat4 &model) {
+        shader.use();
+        shader.setMat4(modelHandle, model);
+    };
 
-    // Store last mouse position
-    sf::Vector2i lastMousePos = sf::Mouse::getPosition(window);
+    // Draws are queued with a sort key each frame and issued in key order, so draws sharing a program,
+    // material and mesh follow each other and opaque objects go front to back
+    RenderQueue renderQueue;
+    enum DRAW {
+        DRAW_LIGHT_CUBE,
+        DRAW_LIT_CUBE,
+        DRAW_PROPS,
+        DRAW_INDIRECT
+    };
+    // The IDs the keys group draws by
+    enum PROGRAM {
+        PROGRAM_FALLBACK,
+        PROGRAM_SOURCE,
+        PROGRAM_LIT,
+        PROGRAM_PROPS
+    };
+    enum MESH {
+        MESH_LIGHT_CUBE,
+        MESH_CUBE,
+        MESH_PROPS
+    };
+    const unsigned int OPAQUE_PASS = 0;
+
+    // Keyboard and mouse are sampled on their own thread between frames
+    std::optional<InputSampler> input;
+    if (!headless) {
+        input.emplace(*window, std::vector<sf::Keyboard::Scancode>{sf::Keyboard::Scancode::W, sf::Keyboard::Scancode::S,
+                                                                   sf::Keyboard::Scancode::A, sf::Keyboard::Scancode::D});
+    }
+
+    // Headless runs fly around the scene on a fixed path, always looking at its middle
+    std::optional<HeadlessRun> headlessRun;
+    const glm::vec3 headlessPathCenter(0.0f, -2.5f, -4.0f);
+    if (headless) {
+        // Compile every program up front, or the first frames would show the fallback
+        // A program that fails to build never becomes ready, give up rather than hang an unattended run
+        sf::Clock compileClock;
+        while (!(litShader.isReady() && propShader.isReady() && sourceShader.isReady())) {
+            if (compileClock.getElapsedTime().asSeconds() > 60.0f) {
+                std::cerr << "ERROR::HEADLESS::SHADERS --> programs still not built after 60 s" << std::endl;
+                shutdownShaderCompiler();
+                return -1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::cout << "Headless: " << headlessOptions.frames << " frames at " << viewportWidth << "x" << viewportHeight
+                  << " on " << glGetString(GL_RENDERER) << std::endl;
+        headlessRun.emplace(headlessOptions, *headlessContext, gpuProfiler);
+    }
+
+    // Frame statistics are shown in the window title once per second
+    sf::Clock statsClock;
 
     bool running = true;
     bool focused = true;
     while (running) {
-        float currentFrame = static_cast<float>(clock.getElapsedTime().asMilliseconds());
-        deltaTime = currentFrame - lastFrame;        
-        lastFrame = currentFrame;
-
-        char movement = 0; 
-        while (const std::optional event = window.pollEvent())
-        {
-            if (event->is<sf::Event::Closed>())
-            {
-                running = false;
-            } 
-            else if (const auto* resized = event->getIf<sf::Event::Resized>())
-            {
-                glViewport(0, 0, resized->size.x, resized->size.y);
-            }
+        const float frameSeconds = frameClock.restart().asSeconds();
 
-            if (event->is<sf::Event::FocusLost>()) {
-                window.setMouseCursorVisible(true);
-                window.setMouseCursorGrabbed(false);
-                focused = false;
-            } 
-            else if (event->is<sf::Event::FocusGained>()) {
-                window.setMouseCursorVisible(false);
-                window.setMouseCursorGrabbed(true);
-                focused = true;
-            }
+        // Animations follow the scene clock, which headless runs step by a fixed amount per frame
+        const float sceneSeconds = headless ? headlessRun->getSceneSeconds() : clock.getElapsedTime().asSeconds();
+
+        // Pick up the GPU times of earlier frames the GPU is done with
+        if (gpuProfiler.beginFrame()) {
+            resolution.adjustScale(gpuProfiler.getLatest(FRAME_SCOPE));
+        }
+
+        // Count this frame's uniform uploads and GL state changes from zero
+        Shader::resetUploadStats();
+        GLState::resetCallStats();
+
+        // Swap in any shaders that were edited and have finished recompiling
+        shaderWatcher.update();
+
+        if (headless) {
+            const float pathAngle = 0.4f * sceneSeconds;
+            const glm::vec3 position = headlessPathCenter + glm::vec3(14.0f * std::cos(pathAngle), 4.0f + 2.0f * std::sin(1.3f * pathAngle),
+                                                                      14.0f * std::sin(pathAngle));
+            const glm::vec3 direction = glm::normalize(headlessPathCenter - position);
+            cam.place(position, glm::degrees(std::atan2(direction.z, direction.x)), glm::degrees(std::asin(direction.y)));
+        } else {
+            while (const std::optional event = window->pollEvent())
+            {
+                input->feed(*event);
 
-            if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
-                if (key->scancode == sf::Keyboard::Scancode::Escape) {
+                if (event->is<sf::Event::Closed>())
+                {
                     running = false;
+                } 
+                else if (const auto* resized = event->getIf<sf::Event::Resized>())
+                {
+                    resolution.resize(resized->size.x, resized->size.y);
+                    cam.setViewport(resized->size.x, resized->size.y);
                 }
 
-                if (key->scancode == sf::Keyboard::Scancode::T) {
-                    // Toggle wireframe draw
-                    static bool showWires = true; 
-                    if (showWires) {
-                        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                    } else {
-                        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-                    }
-                    showWires = !showWires;
+                if (event->is<sf::Event::FocusLost>()) {
+                    window->setMouseCursorVisible(true);
+                    window->setMouseCursorGrabbed(false);
+                    focused = false;
+                    input->setEnabled(false);
+                } 
+                else if (event->is<sf::Event::FocusGained>()) {
+                    window->setMouseCursorVisible(false);
+                    window->setMouseCursorGrabbed(true);
+                    focused = true;
+                    input->setEnabled(true);
                 }
 
-                if (key->scancode == sf::Keyboard::Scancode::W) {
-                    movement |= MOVE_FORWARD;
-                }
-                if (key->scancode == sf::Keyboard::Scancode::S) {
-                    movement |= MOVE_BACKWARD;
-                }
-                if (key->scancode == sf::Keyboard::Scancode::A) {
-                    movement |= MOVE_LEFT;
+                if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+                    if (key->scancode == sf::Keyboard::Scancode::Escape) {
+                        running = false;
+                    }
+
+                    if (key->scancode == sf::Keyboard::Scancode::T) {
+                        // Toggle wireframe draw
+                        static bool showWires = true; 
+                        if (showWires) {
+                            GLState::polygonMode(GL_LINE);
+                        } else {
+                            GLState::polygonMode(GL_FILL);
+                        }
+                        showWires = !showWires;
+                    }
+
+                    if (key->scancode == sf::Keyboard::Scancode::M) {
+                        // Toggle drawing the lit objects through the indirect renderer
+                        indirectMode = !indirectMode;
+                    }
                 }
-                if (key->scancode == sf::Keyboard::Scancode::D) {
-                    movement |= MOVE_RIGHT;
+
+                if (const auto* scrolled = event->getIf<sf::Event::MouseWheelScrolled>()) {
+                    cam.applyZoom(static_cast<float>(scrolled->delta));
                 }
             }
 
-            if (const auto* key = event->getIf<sf::Event::KeyReleased>()) {
-                if (key->scancode == sf::Keyboard::Scancode::W) {
-                    movement &= ~MOVE_FORWARD;
+            // Simulate every step that fell into this frame
+            // The last step ends alpha of a step before the input sample time, each one sees the keys as they were at its end
+            const std::int64_t frameStart = InputSampler::now();
+            const float step = timestep.getStep();
+            const int steps = timestep.advance(frameSeconds);
+            const std::int64_t stepMicroseconds = static_cast<std::int64_t>(step * 1000000.0f);
+            const std::int64_t simulatedUntil = frameStart - static_cast<std::int64_t>(timestep.getAlpha() * stepMicroseconds);
+            for (int i = 0; i < steps; i++) {
+                input->consumeKeysUntil(simulatedUntil - (steps - 1 - i) * stepMicroseconds);
+                cam.beginStep();
+
+                // Apply player movement
+                if (input->isKeyDown(sf::Keyboard::Scancode::W)) {
+                    cam.applyMovement(Camera::MOVEMENT::FORWARD, step);
                 }
-                if (key->scancode == sf::Keyboard::Scancode::S) {
-                    movement &= ~MOVE_BACKWARD;
+                if (input->isKeyDown(sf::Keyboard::Scancode::S)) {
+                    cam.applyMovement(Camera::MOVEMENT::BACKWARD, step);
                 }
-                if (key->scancode == sf::Keyboard::Scancode::A) {
-                    movement &= ~MOVE_LEFT;
+                if (input->isKeyDown(sf::Keyboard::Scancode::A)) {
+                    cam.applyMovement(Camera::MOVEMENT::LEFT, step);
                 }
-                if (key->scancode == sf::Keyboard::Scancode::D) {
-                    movement &= ~MOVE_RIGHT;
+                if (input->isKeyDown(sf::Keyboard::Scancode::D)) {
+                    cam.applyMovement(Camera::MOVEMENT::RIGHT, step);
                 }
-            }
 
-            if (const auto* moved = event->getIf<sf::Event::MouseMoved>()) {       
-                sf::Vector2i delta = moved->position - lastMousePos;
-                cam.applyRotation(glm::vec2(delta.x, delta.y));
-                lastMousePos = moved->position;
+                // Ensure we move due to velocity even if no input is made
+                cam.simulate(step);
             }
 
-            if (const auto* scrolled = event->getIf<sf::Event::MouseWheelScrolled>()) {
-                cam.applyZoom(static_cast<float>(scrolled->delta));
+            // Render between the last two simulated states, so motion stays smooth at any frame rate
+            cam.interpolate(timestep.getAlpha());
+
+            // Late latch the mouse: take every movement sampled up to now, right before the view is uploaded
+            const glm::vec2 mouseDelta = input->takeMouseDelta();
+            if (mouseDelta != glm::vec2(0.0f)) {
+                cam.applyRotation(mouseDelta);
             }
         }
 
-        // Apply player movement
-        if ((movement & MOVE_FORWARD) == MOVE_FORWARD) {
-            cam.applyMovement(Camera::MOVEMENT::FORWARD, deltaTime);
-        }
-        if ((movement & MOVE_BACKWARD) == MOVE_BACKWARD) {
-            cam.applyMovement(Camera::MOVEMENT::BACKWARD, deltaTime);
-        }
-        if ((movement & MOVE_LEFT) == MOVE_LEFT) {
-            cam.applyMovement(Camera::MOVEMENT::LEFT, deltaTime);
-        }
-        if ((movement & MOVE_RIGHT) == MOVE_RIGHT) {
-            cam.applyMovement(Camera::MOVEMENT::RIGHT, deltaTime);
-        }
+        // Camera matrices are computed and uploaded once for every program
+        frameUniforms.update(cam, sceneSeconds);
+        materials.upload();
+        props.upload();
 
-        // Ensure we move due to velocity even if no input is made
-        cam.applyMovement(Camera::MOVEMENT::VELOCITY, deltaTime);
+        // Skip drawing whatever is outside the view
+        views.cullSpheres(sceneBounds);
+
+        // Draw the scene offscreen at this frame's resolution
+        gpuProfiler.begin(FRAME_SCOPE);
+        gpuProfiler.begin(SCENE_SCOPE);
+        resolution.beginFrame();
 
         // Clear buffers
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Prepare to draw
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+        // Only reaches GL when a binding changed, so after the first frame this costs no driver calls
+        GLState::bindTexture(0, GL_TEXTURE_2D, texture1);
+        GLState::bindTexture(1, GL_TEXTURE_2D, texture2);
 
         // Light color
         glm::vec3 lightColor;
-        lightColor.x = sin(clock.getElapsedTime().asSeconds() * 2.0f);
-        lightColor.y = sin(clock.getElapsedTime().asSeconds() * 0.7f);
-        lightColor.z = sin(clock.getElapsedTime().asSeconds() * 1.3f);
+        lightColor.x = sin(sceneSeconds * 2.0f);
+        lightColor.y = sin(sceneSeconds * 0.7f);
+        lightColor.z = sin(sceneSeconds * 1.3f);
         glm::vec3 diffuseColor = lightColor * glm::vec3(0.5f);
         glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f);
 
-        // Cube 1 - light source
-        glBindVertexArray(lightVAO);
-        model = glm::mat4(1.0f); // reset
-        model = glm::translate(model, lightPos);
-        model = glm::scale(model, glm::vec3(0.2f));
-        sourceShader.use();
-        sourceShader.setMat4("model", model);
-        sourceShader.setMat4("view", cam.getView());
-        sourceShader.setMat4("projection", cam.getProjection());
-        // sourceShader.setVec3("lightColor", diffuseColor); // This doesn't work as intended
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
         // Cube 2
-        glBindVertexArray(VAO); // Remembers which buffers are bound already automatically
-        model = glm::mat4(1.0f); // reset
-        model = glm::translate(model, glm::vec3(0, -1, -3));
-        float angle = 20.0f * 2 * static_cast<float>(clock.getElapsedTime().asSeconds());
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-        litShader.use();
-        litShader.setMat4("model", model);
-        litShader.setMat4("view", cam.getView());
-        litShader.setMat4("projection", cam.getProjection());
-        litShader.setVec3("light.position", lightPos);
-        litShader.setVec3("light.ambient", ambientColor);
-        litShader.setVec3("light.diffuse", diffuseColor);
-        litShader.setVec3("viewPos", cam.getPosition());
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glm::mat4 litCubeModel = glm::translate(glm::mat4(1.0f), glm::vec3(0, -1, -3));
+        float angle = 20.0f * 2 * sceneSeconds;
+        litCubeModel = glm::rotate(litCubeModel, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+
+        // Queue whatever is visible, depth is the distance to the object's center over the far plane's
+        const glm::vec3 viewPosition = cam.getPosition();
+        auto depthOf = [&](const glm::vec3 &center) {
+            return glm::length(center - viewPosition) / cam.getFarPlane();
+        };
+        renderQueue.clear();
+        if (views.isVisible(MAIN_VIEW, LIGHT_CUBE)) {
+            renderQueue.push(RenderQueue::makeKey(OPAQUE_PASS, false, sourceShader.isReady() ? PROGRAM_SOURCE : PROGRAM_FALLBACK,
+                                                  0, MESH_LIGHT_CUBE, depthOf(lightPos)), DRAW_LIGHT_CUBE);
+        }
+        if (indirectMode && propShader.isReady()) {
+            // Everything lit goes out as one indirect submission through the instanced variant
+            if (views.isVisible(MAIN_VIEW, LIT_CUBE)) {
+                indirectRenderer.addDraw(cubeMeshID, litCubeModel, cubeMaterial);
+            }
+            if (views.isVisible(MAIN_VIEW, PROPS)) {
+                for (std::size_t i = 0; i < propModels.size(); i++) {
+                    indirectRenderer.addDraw(cubeMeshID, propModels[i], propMaterials[i]);
+                }
+            }
+            renderQueue.push(RenderQueue::makeKey(OPAQUE_PASS, false, PROGRAM_PROPS, 0, 0, 0.0f), DRAW_INDIRECT);
+        } else {
+            if (views.isVisible(MAIN_VIEW, LIT_CUBE)) {
+                renderQueue.push(RenderQueue::makeKey(OPAQUE_PASS, false, litShader.isReady() ? PROGRAM_LIT : PROGRAM_FALLBACK,
+                                                      cubeMaterial, MESH_CUBE, depthOf(glm::vec3(litCubeModel[3]))), DRAW_LIT_CUBE);
+            }
+            // The fallback has no instanced variant, so the props only appear once their program is ready
+            if (views.isVisible(MAIN_VIEW, PROPS) && propShader.isReady()) {
+                renderQueue.push(RenderQueue::makeKey(OPAQUE_PASS, false, PROGRAM_PROPS, propMaterial, MESH_PROPS,
+                                                      depthOf(propGridCenter)), DRAW_PROPS);
+            }
+        }
+        renderQueue.sort();
+
+        for (const RenderQueue::Item &item : renderQueue.getItems()) {
+            switch (item.payload) {
+                case DRAW_LIGHT_CUBE:
+                    GLState::bindVertexArray(lightVAO);
+                    model = glm::mat4(1.0f); // reset
+                    model = glm::translate(model, lightPos);
+                    model = glm::scale(model, glm::vec3(0.2f));
+                    if (sourceShader.isReady()) {
+                        useWithModel(sourceShader, sourceModel, model);
+                    } else {
+                        useWithModel(fallbackShader, fallbackModel, model);
+                    }
+                    // sourceShader.setVec3("lightColor", diffuseColor); // This doesn't work as intended
+                    glDrawElements(GL_TRIANGLES, cubeIndexCount, GL_UNSIGNED_INT, (void*)0);
+                    break;
+                case DRAW_LIT_CUBE:
+                    GLState::bindVertexArray(VAO); // Remembers which buffers are bound already automatically
+                    if (litShader.isReady()) {
+                        useWithModel(litShader, litModel, litCubeModel);
+                        litShader.setVec3(litLightPosition, lightPos);
+                        litShader.setVec3(litLightAmbient, ambientColor);
+                        litShader.setVec3(litLightDiffuse, diffuseColor);
+                        litShader.setInt(litMaterialID, static_cast<int>(cubeMaterial));
+                    } else {
+                        useWithModel(fallbackShader, fallbackModel, litCubeModel);
+                    }
+                    glDrawElements(GL_TRIANGLES, cubeIndexCount, GL_UNSIGNED_INT, (void*)0);
+                    break;
+                case DRAW_PROPS:
+                    // All in one draw call
+                    GLState::bindVertexArray(propVAO);
+                    propShader.use();
+                    propShader.setVec3(propLightPosition, lightPos);
+                    propShader.setVec3(propLightAmbient, ambientColor);
+                    propShader.setVec3(propLightDiffuse, diffuseColor);
+                    glDrawElementsInstanced(GL_TRIANGLES, cubeIndexCount, GL_UNSIGNED_INT, (void*)0, props.size());
+                    break;
+                case DRAW_INDIRECT:
+                    propShader.use();
+                    propShader.setVec3(propLightPosition, lightPos);
+                    propShader.setVec3(propLightAmbient, ambientColor);
+                    propShader.setVec3(propLightDiffuse, diffuseColor);
+                    indirectRenderer.submit();
+                    break;
+            }
+        }
 
         // Unbind current VAO
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
+
+        gpuProfiler.end(SCENE_SCOPE);
+
+        // Upscale to the window
+        gpuProfiler.begin(UPSCALE_SCOPE);
+        resolution.endFrame();
+        gpuProfiler.end(UPSCALE_SCOPE);
+        gpuProfiler.end(FRAME_SCOPE);
+        gpuProfiler.endFrame();
+
+        if (headless) {
+            // Nothing to swap, so finish the frame's GPU work here to have it count towards the frame time
+            glFinish();
+            headlessRun->endFrame(frameClock.getElapsedTime().asSeconds() * 1000.0f);
+            running = headlessRun->isRunning();
+            continue;
+        }
+
+        if (statsClock.getElapsedTime().asSeconds() >= 1.0f) {
+            statsClock.restart();
+            Shader::UploadStats uploads = Shader::getUploadStats();
+            GLState::CallStats stateCalls = GLState::getCallStats();
+            // Rolling average and 95th percentile of each GPU scope
+            std::string gpuTimes;
+            for (unsigned int scope = 0; scope < gpuProfiler.getScopeCount(); scope++) {
+                TimingSummary summary = gpuProfiler.getSummary(scope);
+                char text[64];
+                std::snprintf(text, sizeof(text), "%s%s %.2f/%.2f", scope > 0 ? ", " : "", gpuProfiler.getName(scope).c_str(),
+                              summary.mean, summary.p95);
+                gpuTimes += text;
+            }
+            window->setTitle("Obelisk | uniforms: " + std::to_string(uploads.issued) + " sent, " +
+                            std::to_string(uploads.skipped) + " skipped | state: " +
+                            std::to_string(stateCalls.issued) + " sent, " + std::to_string(stateCalls.elided) + " elided | " +
+                            std::to_string(resolution.getRenderWidth()) + "x" + std::to_string(resolution.getRenderHeight()) +
+                            " | GPU ms (mean/p95): " + gpuTimes +
+                            (indirectMode ? " | indirect: " + std::to_string(indirectRenderer.getSubmittedDraws()) + " draws in " +
+                                            std::to_string(indirectRenderer.getSubmittedCalls()) + " calls" : ""));
+        }
 
         // End the frame (internally swaps front and back buffers)
-        window.display();
+        window->display();
+    }
+
+    // Let the shader worker finish before the window's context goes away
+    shutdownShaderCompiler();
+
+    if (headless) {
+        // No later frame reads back the GPU times of the last few, collect them before reporting
+        gpuProfiler.finish();
+        return headlessRun->finish();
     }
 }
\ No newline at end of file
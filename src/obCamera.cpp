@@ -4,95 +4,150 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-Camera::Camera(glm::vec3 cameraPos, glm::vec3 cameraFront, glm::vec3 cameraUp) : cameraPos(cameraPos), cameraFront(cameraFront), cameraUp(cameraUp) {
-    view = glm::mat4(1.0f);
-    projection = glm::perspective(glm::radians(fov), aspectRatio, zNear, zFar);
+Camera::Camera(glm::vec3 cameraPos, glm::vec3 cameraFront, glm::vec3 cameraUp)
+    : cameraPos(cameraPos), cameraFront(cameraFront), cameraUp(cameraUp), previousPos(cameraPos), renderPos(cameraPos) {
+    updateMatrices();
 }
 
-glm::mat4 Camera::getView() {
-    // LookAt matrix - transform any vector to the camera's coordinate space by multiplying it with this and a translation camera position vector
-    // Note that we have to invert rotation and translation since the world has to move, not the camera
-    // glm has a lookAt function that takes care of this.
-    view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+void Camera::updateMatrices() {
+    if (!viewDirty && !projectionDirty) {
+        return;
+    }
+    if (viewDirty) {
+        // LookAt matrix - transform any vector to the camera's coordinate space by multiplying it with this and a translation camera position vector
+        // Note that we have to invert rotation and translation since the world has to move, not the camera
+        // glm has a lookAt function that takes care of this.
+        view = glm::lookAt(renderPos, renderPos + cameraFront, cameraUp);
+        inverseView = glm::inverse(view);
+    }
+    if (projectionDirty) {
+        projection = glm::perspective(glm::radians(fov), aspectRatio, zNear, zFar);
+        inverseProjection = glm::inverse(projection);
+    }
+    viewProjection = projection * view;
+    inverseViewProjection = inverseView * inverseProjection;
+    frustum = Frustum::fromMatrix(viewProjection);
+    viewDirty = false;
+    projectionDirty = false;
+}
+
+const glm::mat4 &Camera::getView() {
+    updateMatrices();
     return view;
 }
 
-glm::mat4 Camera::getProjection() {
+const glm::mat4 &Camera::getProjection() {
+    updateMatrices();
     return projection;
 }
 
+const glm::mat4 &Camera::getViewProjection() {
+    updateMatrices();
+    return viewProjection;
+}
+
+const glm::mat4 &Camera::getInverseView() {
+    updateMatrices();
+    return inverseView;
+}
+
+const glm::mat4 &Camera::getInverseProjection() {
+    updateMatrices();
+    return inverseProjection;
+}
+
+const glm::mat4 &Camera::getInverseViewProjection() {
+    updateMatrices();
+    return inverseViewProjection;
+}
+
+const Frustum &Camera::getFrustum() {
+    updateMatrices();
+    return frustum;
+}
+
+void Camera::cullSpheres(const BoundingSpheres &spheres, std::vector<std::uint32_t> &visible) {
+    frustumCullSpheres(getFrustum(), spheres, visible);
+}
+
+void Camera::cullBoxes(const BoundingBoxes &boxes, std::vector<std::uint32_t> &visible) {
+    frustumCullBoxes(getFrustum(), boxes, visible);
+}
+
+void Camera::beginStep() {
+    previousPos = cameraPos;
+}
+
 void Camera::applyMovement(MOVEMENT direction, float deltaTime) {
-    float speed = cameraSpeed * deltaTime;
+    const float speed = cameraSpeed * deltaTime;
+    const float accel = cameraAccel * deltaTime;
+    const glm::vec3 right = glm::normalize(glm::cross(cameraFront, cameraUp));
     switch (direction) {
-        case VELOCITY:
-            break;
         case FORWARD:
-            cameraVelocity += cameraAccel * cameraFront;
+            cameraVelocity += accel * cameraFront;
             cameraPos += speed * cameraFront;
             break;
         case BACKWARD:
-            cameraVelocity -= cameraAccel * cameraFront;
+            cameraVelocity -= accel * cameraFront;
             cameraPos -= speed * cameraFront;
             break;
         case LEFT:
-            cameraVelocity -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraAccel;
-            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
+            cameraVelocity -= right * accel;
+            cameraPos -= right * speed;
             break;
         default:
         case RIGHT:
-            cameraVelocity += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraAccel;
-            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
+            cameraVelocity += right * accel;
+            cameraPos += right * speed;
             break;
     }
+}
 
+void Camera::simulate(float deltaTime) {
     // Add velocity
-    cameraPos += cameraVelocity;
+    cameraPos += cameraVelocity * deltaTime;
 
     // Decay camera speed by friction amount
-    if (cameraVelocity.x <= 0) {
-        cameraVelocity.x += cameraFriction;
-    } else {
-        cameraVelocity.x -= cameraFriction;
-    }
-    if (cameraVelocity.y <= 0) {
-        cameraVelocity.y += cameraFriction;
-    } else {
-        cameraVelocity.y -= cameraFriction;
-    }
-    if (cameraVelocity.z <= 0) {
-        cameraVelocity.z += cameraFriction;
-    } else {
-        cameraVelocity.z -= cameraFriction;
-    }
+    const float friction = cameraFriction * deltaTime;
+    for (int axis = 0; axis < 3; axis++) {
+        float &velocity = cameraVelocity[axis];
+        if (velocity <= 0) {
+            velocity += friction;
+        } else {
+            velocity -= friction;
+        }
 
-    // Ensure we hit zero velocity
-    if (glm::abs(cameraVelocity.x) <= velocityThreshold) {
-        cameraVelocity.x = 0;
-    }
-    if (glm::abs(cameraVelocity.y) <= velocityThreshold) {
-        cameraVelocity.y = 0;
-    }
-    if (glm::abs(cameraVelocity.z) <= velocityThreshold) {
-        cameraVelocity.z = 0;
-    }
+        // Ensure we hit zero velocity
+        if (glm::abs(velocity) <= velocityThreshold) {
+            velocity = 0;
+        }
 
-    // Ensure we don't go beyond max velocity
-    if (glm::abs(cameraVelocity.x) >= maxVelocity) {
-        cameraVelocity.x = maxVelocity;
+        // Ensure we don't go beyond max velocity
+        velocity = glm::clamp(velocity, -maxVelocity, maxVelocity);
     }
-    if (glm::abs(cameraVelocity.y) >= maxVelocity) {
-        cameraVelocity.y = maxVelocity;
+}
+
+void Camera::interpolate(float alpha) {
+    const glm::vec3 position = glm::mix(previousPos, cameraPos, alpha);
+    if (position != renderPos) {
+        renderPos = position;
+        viewDirty = true;
     }
-    if (glm::abs(cameraVelocity.z) >= maxVelocity) {
-        cameraVelocity.z = maxVelocity;
+}
+
+void Camera::setViewport(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
     }
+    aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+    projectionDirty = true;
 }
 
 void Camera::applyZoom(float delta) {
     fov += delta;
     if (fov < 1.0f) fov = 1.0f;
     if (fov > 90.0f) fov = 90.0f;
-    projection = glm::perspective(glm::radians(fov), aspectRatio, zNear, zFar);
+    projectionDirty = true;
 }
 
 void Camera::applyRotation(glm::vec2 delta) {
@@ -104,7 +159,18 @@ void Camera::applyRotation(glm::vec2 delta) {
 
     yaw += xoffset;
     pitch += yoffset;
+    updateFront();
+}
+
+void Camera::place(glm::vec3 position, float yaw, float pitch) {
+    cameraPos = previousPos = renderPos = position;
+    cameraVelocity = glm::vec3(0.0f);
+    this->yaw = yaw;
+    this->pitch = pitch;
+    updateFront();
+}
 
+void Camera::updateFront() {
     if (pitch > 89.0f) pitch = 89.0f;
     if (pitch < -89.0f) pitch = -89.0f;
 
@@ -114,4 +180,5 @@ void Camera::applyRotation(glm::vec2 delta) {
     direction.y = sin(glm::radians(pitch));
     direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
     cameraFront = glm::normalize(direction);
+    viewDirty = true;
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef OBCAMERA_H
 #define OBCAMERA_H
 
+#include "obCulling.h"
+#include "obFrustum.h"
+
 #include <glm/glm.hpp>
 
 class Camera {
@@ -9,42 +12,101 @@ class Camera {
             FORWARD,
             BACKWARD,
             RIGHT,
-            LEFT,
-            VELOCITY
+            LEFT
         };
 
         // Setup the projection matrix and initalize camera values
         Camera(glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f));
 
-        // Return an updated view matrix for use in shaders
-        glm::mat4 getView();
+        // Matrices are cached and only rebuilt after the camera has changed,
+        // so calling these for every draw costs nothing past the first call in a frame
+
+        // Return the view matrix for use in shaders
+        const glm::mat4 &getView();
 
         // Return the projection matrix
-        glm::mat4 getProjection();
+        const glm::mat4 &getProjection();
+
+        // Return projection * view
+        const glm::mat4 &getViewProjection();
+
+        // Return the inverses, e.g. to turn screen positions back into world space
+        const glm::mat4 &getInverseView();
+        const glm::mat4 &getInverseProjection();
+        const glm::mat4 &getInverseViewProjection();
+
+        // Return the world space frustum of the view-projection matrix, for culling
+        const Frustum &getFrustum();
 
-        // Return the camera's position
+        // Replace visible with the indices of the volumes the camera can see, see frustumCullSpheres
+        void cullSpheres(const BoundingSpheres &spheres, std::vector<std::uint32_t> &visible);
+        void cullBoxes(const BoundingBoxes &boxes, std::vector<std::uint32_t> &visible);
+
+        // Return the camera's rendered (interpolated) position
         glm::vec3 getPosition() {
-            return cameraPos;
+            return renderPos;
+        }
+
+        // Return the distance to the far clip plane, e.g. to normalize depths
+        float getFarPlane() const {
+            return zFar;
         }
 
-        // Update view matrix in response to player movement
+        // Movement is simulated in fixed steps (see FixedTimestep), once per step:
+        // beginStep(), then applyMovement() for each held direction, then simulate()
+
+        // Remember the current state as the previous step's, for interpolate()
+        void beginStep();
+
+        // Accelerate in response to player movement during this step
         void applyMovement(MOVEMENT direction, float deltaTime);
 
+        // Advance velocity and friction by one step, deltaTime is the step length in seconds
+        void simulate(float deltaTime);
+
+        // Place the rendered camera between the previous and the current step, alpha from 0 to 1
+        // Rotation isn't simulated, it follows the mouse directly for the lowest latency
+        void interpolate(float alpha);
+
+        // Match the projection's aspect ratio to the viewport, e.g. when the window is resized
+        void setViewport(int width, int height);
+
         // Update view matrix in response to player mouse scrolling
         void applyZoom(float delta);
 
         // Update view matrix in response to player mouse movement
         void applyRotation(glm::vec2 delta);
 
+        // Move straight to a position looking along yaw and pitch (in degrees) and stop, e.g. for a scripted path
+        // Previous and current step both move, so there is nothing left to interpolate
+        void place(glm::vec3 position, float yaw, float pitch);
+
     private:
         // Camera vectors
         glm::vec3 cameraPos;
         glm::vec3 cameraFront;
         glm::vec3 cameraUp;
 
-        // Owned matrices
+        // Position at the start of the current step and the interpolated one the view is built from
+        glm::vec3 previousPos;
+        glm::vec3 renderPos;
+
+        // Owned matrices, rebuilt by updateMatrices() when marked dirty
         glm::mat4 view;
         glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::mat4 inverseView;
+        glm::mat4 inverseProjection;
+        glm::mat4 inverseViewProjection;
+        Frustum frustum;
+        bool viewDirty = true;
+        bool projectionDirty = true;
+
+        // Rebuild whichever matrices are out of date
+        void updateMatrices();
+
+        // Clamp pitch and point cameraFront along yaw and pitch
+        void updateFront();
 
         // Camera settings
         float fov = 45.0f;
@@ -52,14 +114,15 @@ class Camera {
         float zNear = 0.1f;
         float zFar = 100.0f;
 
-        // Speed settings
-        float cameraSpeed = 0.005f;
+        // Speed settings, in units per second (and per second squared)
+        // These match the old per-frame values at 144 frames per second
+        float cameraSpeed = 5.0f;
         float cameraSensitivity = 0.1f;
-        float cameraFriction = 0.005f;
-        float cameraAccel = 0.1f;
-        float velocityThreshold = 0.01f; // Needs to be greater than cameraFriction
-        float maxVelocity = 1.0f;
-        glm::vec3 cameraVelocity;
+        float cameraFriction = 103.68f;
+        float cameraAccel = 2073.6f;
+        float velocityThreshold = 1.44f; // Needs to be greater than cameraFriction * step
+        float maxVelocity = 144.0f;
+        glm::vec3 cameraVelocity = glm::vec3(0.0f);
 
         // Camera rotation values
         float pitch = 0.0f;
@@ -0,0 +1,38 @@
+#include "obCpu.h"
+
+#if defined(OB_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+    CpuFeatures detectCpuFeatures() {
+        CpuFeatures features;
+#if defined(OB_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        features.sse41 = __builtin_cpu_supports("sse4.1");
+        features.avx2 = __builtin_cpu_supports("avx2");
+        features.fma = __builtin_cpu_supports("fma");
+#elif defined(OB_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        features.sse41 = (info[2] & (1 << 19)) != 0;
+        features.fma = (info[2] & (1 << 12)) != 0;
+
+        // AVX state also has to be enabled by the OS (OSXSAVE and XCR0 bits 1 and 2)
+        const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            features.avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+        }
+        features.fma = features.fma && osAvx;
+#endif
+        return features;
+    }
+}
+
+const CpuFeatures &getCpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
@@ -0,0 +1,28 @@
+#ifndef OBCPU_H
+#define OBCPU_H
+
+// Runtime CPU feature detection for picking SIMD kernels
+// x86 builds only assume the SSE2 baseline, wider kernels are compiled with OB_TARGET_AVX2
+// and must only be called after checking getCpuFeatures()
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OB_X86 1
+#endif
+
+// Compile a single function for AVX2 + FMA without raising the baseline of the whole build
+// MSVC accepts AVX intrinsics anywhere, so it needs no attribute
+#if defined(OB_X86) && (defined(__GNUC__) || defined(__clang__))
+#define OB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define OB_TARGET_AVX2
+#endif
+
+struct CpuFeatures {
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+};
+
+// Detected once on first use, all false on non-x86 CPUs
+const CpuFeatures &getCpuFeatures();
+
+#endif
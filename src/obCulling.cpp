@@ -0,0 +1,485 @@
+#include "obCulling.h"
+#include "obCpu.h"
+
+#include <cmath>
+
+#ifdef OB_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    // Frustum planes split by component, with the absolute normals the box test needs
+    struct CullPlanes {
+        float x[6], y[6], z[6], w[6];
+        float absX[6], absY[6], absZ[6];
+    };
+
+    CullPlanes splitPlanes(const Frustum &frustum) {
+        CullPlanes planes;
+        for (int p = 0; p < 6; p++) {
+            planes.x[p] = frustum.planes[p].x;
+            planes.y[p] = frustum.planes[p].y;
+            planes.z[p] = frustum.planes[p].z;
+            planes.w[p] = frustum.planes[p].w;
+            planes.absX[p] = std::fabs(planes.x[p]);
+            planes.absY[p] = std::fabs(planes.y[p]);
+            planes.absZ[p] = std::fabs(planes.z[p]);
+        }
+        return planes;
+    }
+
+    // Plane tests for one object, or one batch of 4 (SSE) or 8 (AVX2) objects starting at first
+    // The batch versions return a bit mask with bit n set if object first + n is inside
+
+    bool sphereInside(const CullPlanes &planes, const BoundingSpheres &spheres, std::size_t i) {
+        bool inside = true;
+        for (int p = 0; p < 6; p++) {
+            const float distance = planes.x[p] * spheres.centerX[i] + planes.y[p] * spheres.centerY[i] + planes.z[p] * spheres.centerZ[i] + planes.w[p];
+            inside &= distance >= -spheres.radius[i];
+        }
+        return inside;
+    }
+
+    bool boxInside(const CullPlanes &planes, const BoundingBoxes &boxes, std::size_t i) {
+        // Test the box's center and extents, the extents projected on the normal reach the corner closest to the plane
+        const float centerX = (boxes.minX[i] + boxes.maxX[i]) * 0.5f;
+        const float centerY = (boxes.minY[i] + boxes.maxY[i]) * 0.5f;
+        const float centerZ = (boxes.minZ[i] + boxes.maxZ[i]) * 0.5f;
+        const float extentX = (boxes.maxX[i] - boxes.minX[i]) * 0.5f;
+        const float extentY = (boxes.maxY[i] - boxes.minY[i]) * 0.5f;
+        const float extentZ = (boxes.maxZ[i] - boxes.minZ[i]) * 0.5f;
+        bool inside = true;
+        for (int p = 0; p < 6; p++) {
+            const float distance = planes.x[p] * centerX + planes.y[p] * centerY + planes.z[p] * centerZ + planes.w[p];
+            const float reach = planes.absX[p] * extentX + planes.absY[p] * extentY + planes.absZ[p] * extentZ;
+            inside &= distance + reach >= 0.0f;
+        }
+        return inside;
+    }
+
+#ifdef OB_X86
+    // SSE2 is part of every x86-64 CPU, so these need no runtime check
+
+    // A batch of spheres or boxes loaded once and then tested against any number of frustums
+    struct SphereBatchSSE {
+        __m128 centerX, centerY, centerZ, negativeRadius;
+    };
+
+    struct BoxBatchSSE {
+        __m128 centerX, centerY, centerZ, extentX, extentY, extentZ;
+    };
+
+    SphereBatchSSE loadSpheresSSE(const BoundingSpheres &spheres, std::size_t first) {
+        return {_mm_loadu_ps(&spheres.centerX[first]), _mm_loadu_ps(&spheres.centerY[first]), _mm_loadu_ps(&spheres.centerZ[first]),
+                _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[first]))};
+    }
+
+    BoxBatchSSE loadBoxesSSE(const BoundingBoxes &boxes, std::size_t first) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 minX = _mm_loadu_ps(&boxes.minX[first]);
+        const __m128 minY = _mm_loadu_ps(&boxes.minY[first]);
+        const __m128 minZ = _mm_loadu_ps(&boxes.minZ[first]);
+        const __m128 maxX = _mm_loadu_ps(&boxes.maxX[first]);
+        const __m128 maxY = _mm_loadu_ps(&boxes.maxY[first]);
+        const __m128 maxZ = _mm_loadu_ps(&boxes.maxZ[first]);
+        return {_mm_mul_ps(_mm_add_ps(minX, maxX), half), _mm_mul_ps(_mm_add_ps(minY, maxY), half), _mm_mul_ps(_mm_add_ps(minZ, maxZ), half),
+                _mm_mul_ps(_mm_sub_ps(maxX, minX), half), _mm_mul_ps(_mm_sub_ps(maxY, minY), half), _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half)};
+    }
+
+    int sphereMaskSSE(const CullPlanes &planes, const SphereBatchSSE &batch) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.x[p]), batch.centerX), _mm_set1_ps(planes.w[p]));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.y[p]), batch.centerY));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.z[p]), batch.centerZ));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, batch.negativeRadius));
+        }
+        return _mm_movemask_ps(inside);
+    }
+
+    int boxMaskSSE(const CullPlanes &planes, const BoxBatchSSE &batch) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.x[p]), batch.centerX), _mm_set1_ps(planes.w[p]));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.y[p]), batch.centerY));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.z[p]), batch.centerZ));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.absX[p]), batch.extentX));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.absY[p]), batch.extentY));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.absZ[p]), batch.extentZ));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+        return _mm_movemask_ps(inside);
+    }
+
+    struct SphereBatchAVX2 {
+        __m256 centerX, centerY, centerZ, negativeRadius;
+    };
+
+    struct BoxBatchAVX2 {
+        __m256 centerX, centerY, centerZ, extentX, extentY, extentZ;
+    };
+
+    OB_TARGET_AVX2 SphereBatchAVX2 loadSpheresAVX2(const BoundingSpheres &spheres, std::size_t first) {
+        return {_mm256_loadu_ps(&spheres.centerX[first]), _mm256_loadu_ps(&spheres.centerY[first]), _mm256_loadu_ps(&spheres.centerZ[first]),
+                _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[first]))};
+    }
+
+    OB_TARGET_AVX2 BoxBatchAVX2 loadBoxesAVX2(const BoundingBoxes &boxes, std::size_t first) {
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 minX = _mm256_loadu_ps(&boxes.minX[first]);
+        const __m256 minY = _mm256_loadu_ps(&boxes.minY[first]);
+        const __m256 minZ = _mm256_loadu_ps(&boxes.minZ[first]);
+        const __m256 maxX = _mm256_loadu_ps(&boxes.maxX[first]);
+        const __m256 maxY = _mm256_loadu_ps(&boxes.maxY[first]);
+        const __m256 maxZ = _mm256_loadu_ps(&boxes.maxZ[first]);
+        return {_mm256_mul_ps(_mm256_add_ps(minX, maxX), half), _mm256_mul_ps(_mm256_add_ps(minY, maxY), half), _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half),
+                _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half), _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half), _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half)};
+    }
+
+    OB_TARGET_AVX2 int sphereMaskAVX2(const CullPlanes &planes, const SphereBatchAVX2 &batch) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.x[p]), batch.centerX, _mm256_set1_ps(planes.w[p]));
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.y[p]), batch.centerY, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.z[p]), batch.centerZ, distance);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, batch.negativeRadius, _CMP_GE_OQ));
+        }
+        return _mm256_movemask_ps(inside);
+    }
+
+    OB_TARGET_AVX2 int boxMaskAVX2(const CullPlanes &planes, const BoxBatchAVX2 &batch) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.x[p]), batch.centerX, _mm256_set1_ps(planes.w[p]));
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.y[p]), batch.centerY, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.z[p]), batch.centerZ, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.absX[p]), batch.extentX, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.absY[p]), batch.extentY, distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.absZ[p]), batch.extentZ, distance);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        return _mm256_movemask_ps(inside);
+    }
+#endif
+
+    // Single view kernels write an index for each object and only advance past it when the object is inside,
+    // which keeps the compaction free of unpredictable branches
+    // The output therefore needs room for one full batch past the last visible index
+
+    std::size_t cullSpheresScalar(const CullPlanes &planes, const BoundingSpheres &spheres, std::size_t begin, std::uint32_t* out) {
+        std::size_t written = 0;
+        for (std::size_t i = begin; i < spheres.size(); i++) {
+            out[written] = static_cast<std::uint32_t>(i);
+            written += sphereInside(planes, spheres, i);
+        }
+        return written;
+    }
+
+    std::size_t cullBoxesScalar(const CullPlanes &planes, const BoundingBoxes &boxes, std::size_t begin, std::uint32_t* out) {
+        std::size_t written = 0;
+        for (std::size_t i = begin; i < boxes.size(); i++) {
+            out[written] = static_cast<std::uint32_t>(i);
+            written += boxInside(planes, boxes, i);
+        }
+        return written;
+    }
+
+#ifdef OB_X86
+    // Append the indices of a batch's set mask bits
+    std::size_t compactMask(int mask, int lanes, std::size_t first, std::uint32_t* out) {
+        std::size_t written = 0;
+        for (int lane = 0; lane < lanes; lane++) {
+            out[written] = static_cast<std::uint32_t>(first + lane);
+            written += (mask >> lane) & 1;
+        }
+        return written;
+    }
+
+    std::size_t cullSpheresSSE(const CullPlanes &planes, const BoundingSpheres &spheres, std::uint32_t* out) {
+        const std::size_t batches = spheres.size() / 4 * 4;
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < batches; i += 4) {
+            written += compactMask(sphereMaskSSE(planes, loadSpheresSSE(spheres, i)), 4, i, out + written);
+        }
+        return written + cullSpheresScalar(planes, spheres, batches, out + written);
+    }
+
+    std::size_t cullBoxesSSE(const CullPlanes &planes, const BoundingBoxes &boxes, std::uint32_t* out) {
+        const std::size_t batches = boxes.size() / 4 * 4;
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < batches; i += 4) {
+            written += compactMask(boxMaskSSE(planes, loadBoxesSSE(boxes, i)), 4, i, out + written);
+        }
+        return written + cullBoxesScalar(planes, boxes, batches, out + written);
+    }
+
+    OB_TARGET_AVX2 std::size_t cullSpheresAVX2(const CullPlanes &planes, const BoundingSpheres &spheres, std::uint32_t* out) {
+        const std::size_t batches = spheres.size() / 8 * 8;
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < batches; i += 8) {
+            written += compactMask(sphereMaskAVX2(planes, loadSpheresAVX2(spheres, i)), 8, i, out + written);
+        }
+        return written + cullSpheresScalar(planes, spheres, batches, out + written);
+    }
+
+    OB_TARGET_AVX2 std::size_t cullBoxesAVX2(const CullPlanes &planes, const BoundingBoxes &boxes, std::uint32_t* out) {
+        const std::size_t batches = boxes.size() / 8 * 8;
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < batches; i += 8) {
+            written += compactMask(boxMaskAVX2(planes, loadBoxesAVX2(boxes, i)), 8, i, out + written);
+        }
+        return written + cullBoxesScalar(planes, boxes, batches, out + written);
+    }
+#endif
+
+    // Index of the lowest set bit, value must not be 0
+    std::uint32_t lowestSetBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<std::uint32_t>(__builtin_ctzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<std::uint32_t>(index);
+#else
+        std::uint32_t index = 0;
+        while (((value >> index) & 1) == 0) {
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    // Multi view kernels load each batch once and test it against every view, ORing the
+    // masks into the views' bitsets (batches never straddle a 64 bit word)
+
+    void setVisibleBit(ViewVisibility &visibility, std::size_t view, std::size_t object) {
+        visibility.bits[view * visibility.wordsPerView + object / 64] |= std::uint64_t(1) << (object % 64);
+    }
+
+    void cullSpheresMultiScalar(const std::vector<CullPlanes> &views, const BoundingSpheres &spheres, std::size_t begin, ViewVisibility &visibility) {
+        for (std::size_t i = begin; i < spheres.size(); i++) {
+            for (std::size_t view = 0; view < views.size(); view++) {
+                if (sphereInside(views[view], spheres, i)) {
+                    setVisibleBit(visibility, view, i);
+                }
+            }
+        }
+    }
+
+    void cullBoxesMultiScalar(const std::vector<CullPlanes> &views, const BoundingBoxes &boxes, std::size_t begin, ViewVisibility &visibility) {
+        for (std::size_t i = begin; i < boxes.size(); i++) {
+            for (std::size_t view = 0; view < views.size(); view++) {
+                if (boxInside(views[view], boxes, i)) {
+                    setVisibleBit(visibility, view, i);
+                }
+            }
+        }
+    }
+
+#ifdef OB_X86
+    void storeMask(ViewVisibility &visibility, std::size_t view, std::size_t first, int mask) {
+        visibility.bits[view * visibility.wordsPerView + first / 64] |= static_cast<std::uint64_t>(mask) << (first % 64);
+    }
+
+    void cullSpheresMultiSSE(const std::vector<CullPlanes> &views, const BoundingSpheres &spheres, ViewVisibility &visibility) {
+        const std::size_t batches = spheres.size() / 4 * 4;
+        for (std::size_t i = 0; i < batches; i += 4) {
+            const SphereBatchSSE batch = loadSpheresSSE(spheres, i);
+            for (std::size_t view = 0; view < views.size(); view++) {
+                storeMask(visibility, view, i, sphereMaskSSE(views[view], batch));
+            }
+        }
+        cullSpheresMultiScalar(views, spheres, batches, visibility);
+    }
+
+    void cullBoxesMultiSSE(const std::vector<CullPlanes> &views, const BoundingBoxes &boxes, ViewVisibility &visibility) {
+        const std::size_t batches = boxes.size() / 4 * 4;
+        for (std::size_t i = 0; i < batches; i += 4) {
+            const BoxBatchSSE batch = loadBoxesSSE(boxes, i);
+            for (std::size_t view = 0; view < views.size(); view++) {
+                storeMask(visibility, view, i, boxMaskSSE(views[view], batch));
+            }
+        }
+        cullBoxesMultiScalar(views, boxes, batches, visibility);
+    }
+
+    OB_TARGET_AVX2 void cullSpheresMultiAVX2(const std::vector<CullPlanes> &views, const BoundingSpheres &spheres, ViewVisibility &visibility) {
+        const std::size_t batches = spheres.size() / 8 * 8;
+        for (std::size_t i = 0; i < batches; i += 8) {
+            const SphereBatchAVX2 batch = loadSpheresAVX2(spheres, i);
+            for (std::size_t view = 0; view < views.size(); view++) {
+                storeMask(visibility, view, i, sphereMaskAVX2(views[view], batch));
+            }
+        }
+        cullSpheresMultiScalar(views, spheres, batches, visibility);
+    }
+
+    OB_TARGET_AVX2 void cullBoxesMultiAVX2(const std::vector<CullPlanes> &views, const BoundingBoxes &boxes, ViewVisibility &visibility) {
+        const std::size_t batches = boxes.size() / 8 * 8;
+        for (std::size_t i = 0; i < batches; i += 8) {
+            const BoxBatchAVX2 batch = loadBoxesAVX2(boxes, i);
+            for (std::size_t view = 0; view < views.size(); view++) {
+                storeMask(visibility, view, i, boxMaskAVX2(views[view], batch));
+            }
+        }
+        cullBoxesMultiScalar(views, boxes, batches, visibility);
+    }
+
+    bool useAVX2() {
+        return getCpuFeatures().avx2 && getCpuFeatures().fma;
+    }
+#endif
+
+    // Size and clear the bitsets for a pass, and split every view's planes
+    std::vector<CullPlanes> prepareViews(const std::vector<Frustum> &frustums, std::size_t objectCount, ViewVisibility &visibility) {
+        visibility.viewCount = frustums.size();
+        visibility.objectCount = objectCount;
+        visibility.wordsPerView = (objectCount + 63) / 64;
+        visibility.bits.assign(visibility.viewCount * visibility.wordsPerView, 0);
+
+        std::vector<CullPlanes> views;
+        views.reserve(frustums.size());
+        for (const Frustum &frustum : frustums) {
+            views.push_back(splitPlanes(frustum));
+        }
+        return views;
+    }
+
+    // Room for every object plus one batch of the widest kernel's unconditional writes
+    const std::size_t OUTPUT_SLACK = 8;
+}
+
+std::uint32_t BoundingSpheres::add(const glm::vec3 &center, float radius) {
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    this->radius.push_back(radius);
+    return static_cast<std::uint32_t>(centerX.size() - 1);
+}
+
+void BoundingSpheres::set(std::uint32_t index, const glm::vec3 &center, float radius) {
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    this->radius[index] = radius;
+}
+
+std::size_t BoundingSpheres::size() const {
+    return centerX.size();
+}
+
+void BoundingSpheres::clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+}
+
+std::uint32_t BoundingBoxes::add(const glm::vec3 &min, const glm::vec3 &max) {
+    minX.push_back(min.x);
+    minY.push_back(min.y);
+    minZ.push_back(min.z);
+    maxX.push_back(max.x);
+    maxY.push_back(max.y);
+    maxZ.push_back(max.z);
+    return static_cast<std::uint32_t>(minX.size() - 1);
+}
+
+void BoundingBoxes::set(std::uint32_t index, const glm::vec3 &min, const glm::vec3 &max) {
+    minX[index] = min.x;
+    minY[index] = min.y;
+    minZ[index] = min.z;
+    maxX[index] = max.x;
+    maxY[index] = max.y;
+    maxZ[index] = max.z;
+}
+
+std::size_t BoundingBoxes::size() const {
+    return minX.size();
+}
+
+void BoundingBoxes::clear() {
+    minX.clear();
+    minY.clear();
+    minZ.clear();
+    maxX.clear();
+    maxY.clear();
+    maxZ.clear();
+}
+
+void frustumCullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, std::vector<std::uint32_t> &visible) {
+    const CullPlanes planes = splitPlanes(frustum);
+    visible.resize(spheres.size() + OUTPUT_SLACK);
+    std::size_t written;
+#ifdef OB_X86
+    if (useAVX2()) {
+        written = cullSpheresAVX2(planes, spheres, visible.data());
+    } else {
+        written = cullSpheresSSE(planes, spheres, visible.data());
+    }
+#else
+    written = cullSpheresScalar(planes, spheres, 0, visible.data());
+#endif
+    visible.resize(written);
+}
+
+void frustumCullBoxes(const Frustum &frustum, const BoundingBoxes &boxes, std::vector<std::uint32_t> &visible) {
+    const CullPlanes planes = splitPlanes(frustum);
+    visible.resize(boxes.size() + OUTPUT_SLACK);
+    std::size_t written;
+#ifdef OB_X86
+    if (useAVX2()) {
+        written = cullBoxesAVX2(planes, boxes, visible.data());
+    } else {
+        written = cullBoxesSSE(planes, boxes, visible.data());
+    }
+#else
+    written = cullBoxesScalar(planes, boxes, 0, visible.data());
+#endif
+    visible.resize(written);
+}
+
+bool ViewVisibility::isVisible(std::size_t view, std::size_t object) const {
+    return (bits[view * wordsPerView + object / 64] >> (object % 64)) & 1;
+}
+
+void ViewVisibility::collect(std::size_t view, std::vector<std::uint32_t> &visible) const {
+    visible.clear();
+    const std::uint64_t* words = &bits[view * wordsPerView];
+    for (std::size_t word = 0; word < wordsPerView; word++) {
+        // Walk the set bits only, clearing the lowest one each time
+        for (std::uint64_t remaining = words[word]; remaining != 0; remaining &= remaining - 1) {
+            visible.push_back(static_cast<std::uint32_t>(word * 64 + lowestSetBit(remaining)));
+        }
+    }
+}
+
+void frustumCullSpheres(const std::vector<Frustum> &frustums, const BoundingSpheres &spheres, ViewVisibility &visibility) {
+    const std::vector<CullPlanes> views = prepareViews(frustums, spheres.size(), visibility);
+#ifdef OB_X86
+    if (useAVX2()) {
+        cullSpheresMultiAVX2(views, spheres, visibility);
+    } else {
+        cullSpheresMultiSSE(views, spheres, visibility);
+    }
+#else
+    cullSpheresMultiScalar(views, spheres, 0, visibility);
+#endif
+}
+
+void frustumCullBoxes(const std::vector<Frustum> &frustums, const BoundingBoxes &boxes, ViewVisibility &visibility) {
+    const std::vector<CullPlanes> views = prepareViews(frustums, boxes.size(), visibility);
+#ifdef OB_X86
+    if (useAVX2()) {
+        cullBoxesMultiAVX2(views, boxes, visibility);
+    } else {
+        cullBoxesMultiSSE(views, boxes, visibility);
+    }
+#else
+    cullBoxesMultiScalar(views, boxes, 0, visibility);
+#endif
+}
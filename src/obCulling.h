@@ -0,0 +1,76 @@
+#ifndef OBCULLING_H
+#define OBCULLING_H
+
+#include "obFrustum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Bounding volumes are stored as a structure of arrays so the culling kernels can load
+// one component of 4 (SSE) or 8 (AVX2) objects with a single instruction
+// An object's index is its position in the arrays, it is what ends up in the visible list
+
+// World space bounding spheres
+struct BoundingSpheres {
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+
+    // Append a sphere and return its index
+    std::uint32_t add(const glm::vec3 &center, float radius);
+
+    // Move an existing sphere
+    void set(std::uint32_t index, const glm::vec3 &center, float radius);
+
+    std::size_t size() const;
+    void clear();
+};
+
+// World space axis aligned bounding boxes
+struct BoundingBoxes {
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> minZ;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+    std::vector<float> maxZ;
+
+    // Append a box and return its index
+    std::uint32_t add(const glm::vec3 &min, const glm::vec3 &max);
+
+    // Move an existing box
+    void set(std::uint32_t index, const glm::vec3 &min, const glm::vec3 &max);
+
+    std::size_t size() const;
+    void clear();
+};
+
+// Replace visible with the indices, in ascending order, of the volumes at least partially inside the frustum
+// Picks the widest kernel the CPU supports at runtime (AVX2, SSE2, then scalar)
+void frustumCullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, std::vector<std::uint32_t> &visible);
+void frustumCullBoxes(const Frustum &frustum, const BoundingBoxes &boxes, std::vector<std::uint32_t> &visible);
+
+// Which objects each of several views can see, one bitset per view with bit i set if object i is visible
+struct ViewVisibility {
+    std::size_t viewCount = 0;
+    std::size_t objectCount = 0;
+    std::size_t wordsPerView = 0;
+
+    // View v's bitset is the wordsPerView words starting at bits[v * wordsPerView]
+    std::vector<std::uint64_t> bits;
+
+    bool isVisible(std::size_t view, std::size_t object) const;
+
+    // Replace visible with the indices, in ascending order, of the objects the view can see
+    void collect(std::size_t view, std::vector<std::uint32_t> &visible) const;
+};
+
+// Cull against every frustum in a single pass over the volumes, so each batch of bounds is loaded once
+// however many views (shadow cascades, split screen, reflections) there are
+void frustumCullSpheres(const std::vector<Frustum> &frustums, const BoundingSpheres &spheres, ViewVisibility &visibility);
+void frustumCullBoxes(const std::vector<Frustum> &frustums, const BoundingBoxes &boxes, ViewVisibility &visibility);
+
+#endif
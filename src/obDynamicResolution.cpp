@@ -0,0 +1,149 @@
+#include "obDynamicResolution.h"
+#include "obGLState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // Aim a little under the target so small spikes don't immediately miss it
+    const float TARGET_HEADROOM = 0.9f;
+
+    // Ignore changes smaller than this, so the resolution doesn't flicker between nearly equal scales
+    const float SCALE_DEADBAND = 0.02f;
+
+    // Fraction of the way to the desired scale taken per measurement
+    const float SCALE_SMOOTHING = 0.25f;
+
+    GLuint createRenderbuffer(GLenum format, int samples, int width, int height) {
+        GLuint renderbuffer;
+        glGenRenderbuffers(1, &renderbuffer);
+        GLState::bindRenderbuffer(renderbuffer);
+        if (samples > 1) {
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, width, height);
+        } else {
+            glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+        }
+        return renderbuffer;
+    }
+
+    GLuint createFramebuffer(GLuint color, GLuint depth) {
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        if (depth != 0) {
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "ERROR::DYNAMIC_RESOLUTION::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+        return framebuffer;
+    }
+}
+
+DynamicResolution::DynamicResolution(int windowWidth, int windowHeight, int samples, float minScale, float maxScale, float targetMilliseconds)
+    : windowWidth(windowWidth), windowHeight(windowHeight), samples(samples), minScale(minScale), maxScale(maxScale),
+      targetMilliseconds(targetMilliseconds), scale(maxScale) {
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    this->samples = std::min(samples, static_cast<int>(maxSamples));
+    createTargets();
+}
+
+DynamicResolution::~DynamicResolution() {
+    destroyTargets();
+}
+
+void DynamicResolution::createTargets() {
+    const int width = std::max(1, static_cast<int>(std::ceil(windowWidth * maxScale)));
+    const int height = std::max(1, static_cast<int>(std::ceil(windowHeight * maxScale)));
+
+    if (samples > 1) {
+        msaaColor = createRenderbuffer(GL_RGBA8, samples, width, height);
+        msaaDepth = createRenderbuffer(GL_DEPTH24_STENCIL8, samples, width, height);
+        msaaFBO = createFramebuffer(msaaColor, msaaDepth);
+    } else {
+        // Without multisampling the scene is drawn straight into the resolve target, which then needs depth
+        resolveDepth = createRenderbuffer(GL_DEPTH24_STENCIL8, 1, width, height);
+    }
+    resolveColor = createRenderbuffer(GL_RGBA8, 1, width, height);
+    resolveFBO = createFramebuffer(resolveColor, resolveDepth);
+
+    GLState::bindRenderbuffer(0);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::destroyTargets() {
+    const GLuint framebuffers[] = {msaaFBO, resolveFBO};
+    const GLuint renderbuffers[] = {msaaColor, msaaDepth, resolveColor, resolveDepth};
+    GLState::deleteFramebuffers(2, framebuffers);
+    GLState::deleteRenderbuffers(4, renderbuffers);
+    msaaFBO = msaaColor = msaaDepth = 0;
+    resolveFBO = resolveColor = resolveDepth = 0;
+}
+
+void DynamicResolution::resize(int windowWidth, int windowHeight) {
+    if (windowWidth <= 0 || windowHeight <= 0) {
+        return;
+    }
+    this->windowWidth = windowWidth;
+    this->windowHeight = windowHeight;
+    destroyTargets();
+    createTargets();
+}
+
+void DynamicResolution::beginFrame() {
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, samples > 1 ? msaaFBO : resolveFBO);
+    GLState::viewport(0, 0, getRenderWidth(), getRenderHeight());
+}
+
+void DynamicResolution::endFrame() {
+    const int width = getRenderWidth();
+    const int height = getRenderHeight();
+
+    // A multisample resolve can't scale, so resolve at the render size first
+    if (samples > 1) {
+        GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
+        GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    // Upscale into the window, which must not be multisampled itself for a scaling blit
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    GLState::bindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+}
+
+void DynamicResolution::setOutputFramebuffer(GLuint framebuffer) {
+    outputFBO = framebuffer;
+}
+
+void DynamicResolution::adjustScale(float gpuMilliseconds) {
+    if (gpuMilliseconds <= 0.0f) {
+        return;
+    }
+    // GPU time grows with the pixel count, which is the square of the per axis scale
+    const float desired = std::clamp(scale * std::sqrt(targetMilliseconds * TARGET_HEADROOM / gpuMilliseconds), minScale, maxScale);
+    if (std::fabs(desired - scale) < SCALE_DEADBAND) {
+        // Still settle exactly on a bound rather than stopping just short of it
+        if (desired == minScale || desired == maxScale) {
+            scale = desired;
+        }
+        return;
+    }
+    scale += (desired - scale) * SCALE_SMOOTHING;
+}
+
+float DynamicResolution::getScale() const {
+    return scale;
+}
+
+int DynamicResolution::getRenderWidth() const {
+    return std::max(1, static_cast<int>(windowWidth * scale));
+}
+
+int DynamicResolution::getRenderHeight() const {
+    return std::max(1, static_cast<int>(windowHeight * scale));
+}
@@ -0,0 +1,62 @@
+#ifndef OBDYNAMICRESOLUTION_H
+#define OBDYNAMICRESOLUTION_H
+
+#include <glad/glad.h>
+
+// Renders the scene into an offscreen (optionally multisampled) target whose resolution follows the
+// measured GPU frame time, fed in through adjustScale(), then upscales it to the window at the end of the frame
+// The targets are allocated at the largest scale and only a corner of them is rendered to,
+// so changing the scale never reallocates anything
+class DynamicResolution {
+    public:
+        // Scales are per axis relative to the window size, targetMilliseconds is the GPU time per frame to stay under
+        DynamicResolution(int windowWidth, int windowHeight, int samples = 4, float minScale = 0.5f, float maxScale = 1.0f,
+                          float targetMilliseconds = 1000.0f / 144.0f);
+        ~DynamicResolution();
+
+        DynamicResolution(const DynamicResolution &) = delete;
+        DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+        // Reallocate the targets for a new window size, sizes of zero (a minimized window) are ignored
+        void resize(int windowWidth, int windowHeight);
+
+        // Bind the offscreen target and its viewport at the current scale
+        void beginFrame();
+
+        // Resolve and upscale the frame into the output framebuffer, leaves the output framebuffer bound
+        void endFrame();
+
+        // Move the scale towards the one that would have hit the target, given a new GPU frame time
+        void adjustScale(float gpuMilliseconds);
+
+        // Where endFrame() puts the frame, 0 (the window's framebuffer) unless there is no window
+        void setOutputFramebuffer(GLuint framebuffer);
+
+        float getScale() const;
+        int getRenderWidth() const;
+        int getRenderHeight() const;
+
+    private:
+        int windowWidth;
+        int windowHeight;
+        int samples;
+        float minScale;
+        float maxScale;
+        float targetMilliseconds;
+
+        float scale;
+        GLuint outputFBO = 0;
+
+        // The scene is drawn into msaaFBO (when multisampling) and resolved into resolveFBO
+        GLuint msaaFBO = 0;
+        GLuint msaaColor = 0;
+        GLuint msaaDepth = 0;
+        GLuint resolveFBO = 0;
+        GLuint resolveColor = 0;
+        GLuint resolveDepth = 0;
+
+        void createTargets();
+        void destroyTargets();
+};
+
+#endif
@@ -0,0 +1,24 @@
+#include "obFixedTimestep.h"
+
+FixedTimestep::FixedTimestep(float step, int maxSteps) : step(step), maxSteps(maxSteps) {}
+
+int FixedTimestep::advance(float frameSeconds) {
+    accumulator += frameSeconds;
+    int steps = 0;
+    while (accumulator >= step && steps < maxSteps) {
+        accumulator -= step;
+        steps++;
+    }
+    if (steps == maxSteps && accumulator >= step) {
+        accumulator = 0.0f;
+    }
+    return steps;
+}
+
+float FixedTimestep::getAlpha() const {
+    return accumulator / step;
+}
+
+float FixedTimestep::getStep() const {
+    return step;
+}
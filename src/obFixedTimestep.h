@@ -0,0 +1,36 @@
+#ifndef OBFIXEDTIMESTEP_H
+#define OBFIXEDTIMESTEP_H
+
+// Accumulates real frame time and hands it out as fixed simulation steps,
+// so simulated motion is the same at any frame rate
+// Simulated objects keep their state at the previous and the current step and
+// render at a blend of the two given by getAlpha(), e.g. for the Camera:
+//     for (int i = timestep.advance(frameSeconds); i > 0; i--) {
+//         cam.beginStep();
+//         ...input...
+//         cam.simulate(timestep.getStep());
+//     }
+//     cam.interpolate(timestep.getAlpha());
+class FixedTimestep {
+    public:
+        // step is the simulated time per step in seconds
+        // A frame never runs more than maxSteps, time beyond that is dropped instead of
+        // making the next frame even slower (the "spiral of death")
+        FixedTimestep(float step = 1.0f / 144.0f, int maxSteps = 8);
+
+        // Add a frame's real time (in seconds) and return how many steps to simulate for it
+        int advance(float frameSeconds);
+
+        // How far the leftover time is into the next step, from 0 to 1
+        float getAlpha() const;
+
+        // Seconds per step
+        float getStep() const;
+
+    private:
+        float step;
+        int maxSteps;
+        float accumulator = 0.0f;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "obFrameUniforms.h"
+#include "obCamera.h"
+#include "obGLState.h"
+#include "obUniformBlocks.h"
+
+FrameUniforms::FrameUniforms() {
+    glGenBuffers(1, &UBO);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, UBO);
+}
+
+FrameUniforms::~FrameUniforms() {
+    GLState::deleteBuffers(1, &UBO);
+}
+
+void FrameUniforms::update(Camera &camera, float time) {
+    data.view = camera.getView();
+    data.projection = camera.getProjection();
+    data.viewProjection = camera.getViewProjection();
+    data.viewPos = glm::vec4(camera.getPosition(), 1.0f);
+    data.time = time;
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+}
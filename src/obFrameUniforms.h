@@ -0,0 +1,39 @@
+#ifndef OBFRAMEUNIFORMS_H
+#define OBFRAMEUNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class Camera;
+
+// std140 mirror of the FrameData block in shaders/frame.glsl, keep the two in sync
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 viewPos; // w is unused
+    float time;
+    float padding[3];
+};
+static_assert(sizeof(FrameData) == 224, "FrameData must match the std140 layout of the FrameData block");
+
+// Frame-global uniforms shared by every program through one uniform buffer
+// Filled once per frame instead of once per program
+class FrameUniforms {
+    public:
+        // Create the buffer and attach it to FRAME_BLOCK_BINDING
+        FrameUniforms();
+        ~FrameUniforms();
+
+        FrameUniforms(const FrameUniforms &) = delete;
+        FrameUniforms &operator=(const FrameUniforms &) = delete;
+
+        // Upload this frame's camera matrices and time (in seconds)
+        void update(Camera &camera, float time);
+
+    private:
+        unsigned int UBO;
+        FrameData data;
+};
+
+#endif
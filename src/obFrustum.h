@@ -0,0 +1,20 @@
+#ifndef OBFRUSTUM_H
+#define OBFRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// The six planes bounding what a view-projection matrix can see, in world space
+// Each plane is (normal, distance) with the normal pointing into the frustum and normalized,
+// so dot(normal, point) + distance is the signed distance of a point from the plane
+struct Frustum {
+    // Left, right, bottom, top, near, far
+    glm::vec4 planes[6];
+
+    // Extract the planes of a view-projection matrix (Gribb & Hartmann)
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+
+    // Whether a sphere is at least partially inside, conservative near the frustum's corners
+    bool intersectsSphere(const glm::vec3 &center, float radius) const;
+};
+
+#endif
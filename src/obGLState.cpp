@@ -0,0 +1,277 @@
+#include "obGLState.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+    // Value of state that hasn't been set through GLState yet, so the first call always goes through
+    const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    // A value of some per target (or per capability) state
+    struct TargetBinding {
+        GLenum target;
+        GLuint value;
+    };
+
+    struct IndexedBinding {
+        GLenum target;
+        GLuint index;
+        GLuint buffer;
+    };
+
+    struct State {
+        GLuint program = UNKNOWN;
+        GLuint pipeline = UNKNOWN;
+        GLuint vertexArray = UNKNOWN;
+        GLuint readFramebuffer = UNKNOWN;
+        GLuint drawFramebuffer = UNKNOWN;
+        GLuint renderbuffer = UNKNOWN;
+        GLuint activeTextureUnit = UNKNOWN;
+
+        // Only the few targets and capabilities actually used end up here, a linear search is fine
+        std::vector<TargetBinding> buffers;
+        std::vector<IndexedBinding> indexedBuffers;
+        std::vector<TargetBinding> capabilities;
+
+        // Per texture unit
+        std::vector<std::vector<TargetBinding>> textures;
+        std::vector<GLuint> samplers;
+
+        GLuint blendSource = UNKNOWN;
+        GLuint blendDestination = UNKNOWN;
+        GLuint depthFunction = UNKNOWN;
+        GLuint depthWrite = UNKNOWN;
+        GLuint polygonMode = UNKNOWN;
+        GLint viewport[4] = {-1, -1, -1, -1};
+    };
+
+    State state;
+    GLState::CallStats callStats;
+
+    // Record value as the new state, returns false (and counts an elided call) if it already was
+    bool change(GLuint &cached, GLuint value) {
+        if (cached == value) {
+            callStats.elided++;
+            return false;
+        }
+        cached = value;
+        callStats.issued++;
+        return true;
+    }
+
+    GLuint &lookup(std::vector<TargetBinding> &bindings, GLenum target) {
+        for (TargetBinding &binding : bindings) {
+            if (binding.target == target) {
+                return binding.value;
+            }
+        }
+        bindings.push_back({target, UNKNOWN});
+        return bindings.back().value;
+    }
+
+    // Set every cached value equal to name back to unknown
+    void forget(GLuint &cached, GLuint name) {
+        if (cached == name) {
+            cached = UNKNOWN;
+        }
+    }
+
+    void forget(std::vector<TargetBinding> &bindings, GLuint name) {
+        for (TargetBinding &binding : bindings) {
+            forget(binding.value, name);
+        }
+    }
+}
+
+void GLState::useProgram(GLuint program) {
+    if (change(state.program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void GLState::bindProgramPipeline(GLuint pipeline) {
+    if (change(state.pipeline, pipeline)) {
+        glBindProgramPipeline(pipeline);
+    }
+}
+
+void GLState::bindVertexArray(GLuint vertexArray) {
+    if (change(state.vertexArray, vertexArray)) {
+        glBindVertexArray(vertexArray);
+        lookup(state.buffers, GL_ELEMENT_ARRAY_BUFFER) = UNKNOWN;
+    }
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    if (change(lookup(state.buffers, target), buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    auto binding = std::find_if(state.indexedBuffers.begin(), state.indexedBuffers.end(), [&](const IndexedBinding &indexed) {
+        return indexed.target == target && indexed.index == index;
+    });
+    if (binding == state.indexedBuffers.end()) {
+        state.indexedBuffers.push_back({target, index, UNKNOWN});
+        binding = state.indexedBuffers.end() - 1;
+    }
+    if (change(binding->buffer, buffer)) {
+        glBindBufferBase(target, index, buffer);
+        lookup(state.buffers, target) = buffer;
+    }
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    if (unit >= state.textures.size()) {
+        state.textures.resize(unit + 1);
+    }
+    if (change(lookup(state.textures[unit], target), texture)) {
+        if (change(state.activeTextureUnit, unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+        glBindTexture(target, texture);
+    }
+}
+
+void GLState::bindSampler(GLuint unit, GLuint sampler) {
+    if (unit >= state.samplers.size()) {
+        state.samplers.resize(unit + 1, UNKNOWN);
+    }
+    if (change(state.samplers[unit], sampler)) {
+        glBindSampler(unit, sampler);
+    }
+}
+
+void GLState::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    if (target == GL_FRAMEBUFFER) {
+        if (state.readFramebuffer == framebuffer && state.drawFramebuffer == framebuffer) {
+            callStats.elided++;
+            return;
+        }
+        state.readFramebuffer = state.drawFramebuffer = framebuffer;
+        callStats.issued++;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        return;
+    }
+    GLuint &cached = target == GL_READ_FRAMEBUFFER ? state.readFramebuffer : state.drawFramebuffer;
+    if (change(cached, framebuffer)) {
+        glBindFramebuffer(target, framebuffer);
+    }
+}
+
+void GLState::bindRenderbuffer(GLuint renderbuffer) {
+    if (change(state.renderbuffer, renderbuffer)) {
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    }
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+    if (change(lookup(state.capabilities, capability), enabled ? 1 : 0)) {
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    if (state.blendSource == source && state.blendDestination == destination) {
+        callStats.elided++;
+        return;
+    }
+    state.blendSource = source;
+    state.blendDestination = destination;
+    callStats.issued++;
+    glBlendFunc(source, destination);
+}
+
+void GLState::depthFunc(GLenum function) {
+    if (change(state.depthFunction, function)) {
+        glDepthFunc(function);
+    }
+}
+
+void GLState::depthMask(bool write) {
+    if (change(state.depthWrite, write ? 1 : 0)) {
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GLState::polygonMode(GLenum mode) {
+    if (change(state.polygonMode, mode)) {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const GLint requested[4] = {x, y, width, height};
+    if (std::equal(requested, requested + 4, state.viewport)) {
+        callStats.elided++;
+        return;
+    }
+    std::copy(requested, requested + 4, state.viewport);
+    callStats.issued++;
+    glViewport(x, y, width, height);
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        forget(state.buffers, buffers[i]);
+        for (IndexedBinding &binding : state.indexedBuffers) {
+            forget(binding.buffer, buffers[i]);
+        }
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < count; i++) {
+        forget(state.vertexArray, vertexArrays[i]);
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; i++) {
+        for (std::vector<TargetBinding> &unit : state.textures) {
+            forget(unit, textures[i]);
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+void GLState::deleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        forget(state.readFramebuffer, framebuffers[i]);
+        forget(state.drawFramebuffer, framebuffers[i]);
+    }
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLState::deleteRenderbuffers(GLsizei count, const GLuint* renderbuffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        forget(state.renderbuffer, renderbuffers[i]);
+    }
+    glDeleteRenderbuffers(count, renderbuffers);
+}
+
+void GLState::deleteProgramPipelines(GLsizei count, const GLuint* pipelines) {
+    for (GLsizei i = 0; i < count; i++) {
+        forget(state.pipeline, pipelines[i]);
+    }
+    glDeleteProgramPipelines(count, pipelines);
+}
+
+void GLState::invalidate() {
+    state = State();
+}
+
+GLState::CallStats GLState::getCallStats() {
+    return callStats;
+}
+
+void GLState::resetCallStats() {
+    callStats = CallStats();
+}
@@ -0,0 +1,60 @@
+#ifndef OBGLSTATE_H
+#define OBGLSTATE_H
+
+#include <glad/glad.h>
+
+// Shadow of the GL binding and fixed function state, every bind in the renderer goes through here
+// A call that wouldn't change anything is skipped instead of reaching the driver
+// There is one GL context we render with, so the shadow is global and must only be used from the main thread
+// Anything that changes state behind its back (another library, a raw gl* call) has to call invalidate()
+class GLState {
+    public:
+        static void useProgram(GLuint program);
+        static void bindProgramPipeline(GLuint pipeline);
+        static void bindVertexArray(GLuint vertexArray);
+
+        // GL_ELEMENT_ARRAY_BUFFER belongs to the bound vertex array, it is forgotten whenever that changes
+        static void bindBuffer(GLenum target, GLuint buffer);
+
+        // Also binds the buffer to target itself, like glBindBufferBase does
+        static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+        // Makes unit the active texture unit only when the texture actually needs binding
+        static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+        static void bindSampler(GLuint unit, GLuint sampler);
+
+        // GL_FRAMEBUFFER binds both the read and the draw framebuffer
+        static void bindFramebuffer(GLenum target, GLuint framebuffer);
+        static void bindRenderbuffer(GLuint renderbuffer);
+
+        // glEnable / glDisable
+        static void setEnabled(GLenum capability, bool enabled);
+        static void blendFunc(GLenum source, GLenum destination);
+        static void depthFunc(GLenum function);
+        static void depthMask(bool write);
+        static void polygonMode(GLenum mode);
+        static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        // Delete objects, forgetting their bindings first since GL unbinds them and a new object may reuse the name
+        static void deleteBuffers(GLsizei count, const GLuint* buffers);
+        static void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+        static void deleteTextures(GLsizei count, const GLuint* textures);
+        static void deleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+        static void deleteRenderbuffers(GLsizei count, const GLuint* renderbuffers);
+        static void deleteProgramPipelines(GLsizei count, const GLuint* pipelines);
+
+        // Forget everything, the next call of each kind goes through
+        static void invalidate();
+
+        // State changes sent to GL and elided as no-ops
+        struct CallStats {
+            unsigned int issued = 0;
+            unsigned int elided = 0;
+        };
+
+        // Counts since the last reset, e.g. reset at the start of each frame to get per-frame numbers
+        static CallStats getCallStats();
+        static void resetCallStats();
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "obGpuProfiler.h"
+
+#include <algorithm>
+#include <utility>
+
+GpuProfiler::GpuProfiler(std::size_t historyLength) : historyLength(std::max<std::size_t>(historyLength, 1)) {
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (FrameQueries &queries : frames) {
+        if (!queries.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(queries.queries.size()), queries.queries.data());
+        }
+    }
+}
+
+unsigned int GpuProfiler::getScope(const std::string &name) {
+    for (std::size_t i = 0; i < scopes.size(); i++) {
+        if (scopes[i].name == name) {
+            return static_cast<unsigned int>(i);
+        }
+    }
+    Scope scope;
+    scope.name = name;
+    scope.history.resize(historyLength);
+    scopes.push_back(std::move(scope));
+    return static_cast<unsigned int>(scopes.size() - 1);
+}
+
+bool GpuProfiler::beginFrame() {
+    // Frames finish in order, read them back oldest first and stop at the first one still in flight
+    bool updated = false;
+    for (int i = 1; i <= FRAME_LATENCY; i++) {
+        FrameQueries &queries = frames[(current + i) % FRAME_LATENCY];
+        if (!queries.pending) {
+            continue;
+        }
+        if (!readBack(queries)) {
+            break;
+        }
+        updated = updated || !queries.discarded;
+    }
+
+    current = (current + 1) % FRAME_LATENCY;
+    FrameQueries &queries = frames[current];
+    recording = !queries.pending;
+    if (recording) {
+        queries.marks.clear();
+        queries.discarded = false;
+    } else {
+        dropped++;
+    }
+    return updated;
+}
+
+void GpuProfiler::endFrame() {
+    if (recording) {
+        frames[current].pending = !frames[current].marks.empty();
+        recording = false;
+    }
+}
+
+void GpuProfiler::finish() {
+    endFrame();
+    for (int i = 1; i <= FRAME_LATENCY; i++) {
+        FrameQueries &queries = frames[(current + i) % FRAME_LATENCY];
+        if (queries.pending) {
+            readBack(queries, true);
+        }
+    }
+}
+
+void GpuProfiler::begin(unsigned int scope) {
+    mark(scope, true);
+}
+
+void GpuProfiler::end(unsigned int scope) {
+    mark(scope, false);
+}
+
+void GpuProfiler::mark(unsigned int scope, bool begin) {
+    if (!recording || scope >= scopes.size()) {
+        return;
+    }
+    FrameQueries &queries = frames[current];
+    const std::size_t index = queries.marks.size();
+    // Pools grow to the most timestamps any frame took and then stay that size
+    if (index == queries.queries.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        queries.queries.push_back(query);
+    }
+    glQueryCounter(queries.queries[index], GL_TIMESTAMP);
+    queries.marks.push_back({scope, begin});
+}
+
+bool GpuProfiler::readBack(FrameQueries &queries, bool wait) {
+    // The last timestamp is written last, once it is available all of them are
+    // Reading GL_QUERY_RESULT itself waits for it, so when waiting there is nothing to check
+    if (!wait) {
+        GLint available = 0;
+        glGetQueryObjectiv(queries.queries[queries.marks.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return false;
+        }
+    }
+
+    for (std::size_t i = 0; i < queries.marks.size(); i++) {
+        const Mark &mark = queries.marks[i];
+        Scope &scope = scopes[mark.scope];
+        GLuint64 timestamp = 0;
+        glGetQueryObjectui64v(queries.queries[i], GL_QUERY_RESULT, &timestamp);
+        if (mark.begin) {
+            scope.opened = timestamp;
+        } else if (timestamp >= scope.opened) {
+            scope.total += timestamp - scope.opened;
+            scope.seen = true;
+        }
+    }
+
+    for (Scope &scope : scopes) {
+        if (!scope.seen || queries.discarded) {
+            scope.total = 0;
+            scope.seen = false;
+            continue;
+        }
+        scope.latest = static_cast<float>(scope.total) / 1000000.0f;
+        scope.history[scope.next] = scope.latest;
+        scope.next = (scope.next + 1) % scope.history.size();
+        scope.count = std::min(scope.count + 1, scope.history.size());
+        scope.total = 0;
+        scope.seen = false;
+    }
+    queries.pending = false;
+    return true;
+}
+
+void GpuProfiler::clearHistory() {
+    for (FrameQueries &queries : frames) {
+        queries.discarded = true;
+    }
+    for (Scope &scope : scopes) {
+        scope.next = 0;
+        scope.count = 0;
+        scope.latest = 0.0f;
+    }
+}
+
+std::size_t GpuProfiler::getScopeCount() const {
+    return scopes.size();
+}
+
+const std::string &GpuProfiler::getName(unsigned int scope) const {
+    return scopes[scope].name;
+}
+
+float GpuProfiler::getLatest(unsigned int scope) const {
+    return scopes[scope].latest;
+}
+
+TimingSummary GpuProfiler::getSummary(unsigned int scope) const {
+    const Scope &source = scopes[scope];
+    return summarizeTimes(std::vector<float>(source.history.begin(), source.history.begin() + source.count));
+}
+
+unsigned int GpuProfiler::getDroppedFrames() const {
+    return dropped;
+}
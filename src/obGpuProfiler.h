@@ -0,0 +1,108 @@
+#ifndef OBGPUPROFILER_H
+#define OBGPUPROFILER_H
+
+#include "obTimingSummary.h"
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Measures the GPU time of named scopes, e.g. one per render pass, with GL_TIMESTAMP queries
+// Timestamps (unlike GL_TIME_ELAPSED) can nest and overlap, so a "frame" scope can enclose the passes inside it
+// Each frame's queries come from their own pool and are only read back in a later frame, once the GPU
+// says they are available, so measuring never stalls the CPU
+// Every scope keeps its per frame times of the last frames for rolling averages and percentiles
+class GpuProfiler {
+    public:
+        // Frames whose queries can be in flight at once, a frame finding its pool still waiting isn't measured
+        static constexpr int FRAME_LATENCY = 4;
+
+        // historyLength is how many frames the averages and percentiles cover
+        explicit GpuProfiler(std::size_t historyLength = 120);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler &) = delete;
+        GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+        // Get the ID of a named scope, registering it the first time the name is seen
+        // Look the IDs up once, not every frame
+        unsigned int getScope(const std::string &name);
+
+        // Read back every earlier frame the GPU has finished, then start recording a new one
+        // Returns whether new times came in, so anything reacting to them only does so once per result
+        bool beginFrame();
+        void endFrame();
+
+        // Wait for the frames still in flight and read them back, so the times cover the last frames too
+        // Blocks until the GPU is done with them, call it once rendering is over, e.g. before reporting
+        void finish();
+
+        // Bracket the commands of a scope, a scope used several times in a frame adds up its times
+        void begin(unsigned int scope);
+        void end(unsigned int scope);
+
+        // Forget every recorded time, including those of frames still in flight, e.g. after warming up
+        // The scopes stay registered
+        void clearHistory();
+
+        std::size_t getScopeCount() const;
+        const std::string &getName(unsigned int scope) const;
+
+        // Newest per frame time of a scope, 0 until its first result
+        float getLatest(unsigned int scope) const;
+
+        // Averages and percentiles over the recorded frames, see summarizeTimes()
+        TimingSummary getSummary(unsigned int scope) const;
+
+        // Frames that went unmeasured because their pool was still waiting on the GPU
+        unsigned int getDroppedFrames() const;
+
+    private:
+        struct Scope {
+            std::string name;
+
+            // Ring of per frame times, next is where the newest one goes
+            std::vector<float> history;
+            std::size_t next = 0;
+            std::size_t count = 0;
+            float latest = 0.0f;
+
+            // Used while reading back a frame
+            GLuint64 opened = 0;
+            GLuint64 total = 0;
+            bool seen = false;
+        };
+
+        // One timestamp, taken where a scope begins or ends
+        struct Mark {
+            unsigned int scope;
+            bool begin;
+        };
+
+        // The queries of one frame, reused frame after frame
+        struct FrameQueries {
+            std::vector<GLuint> queries;
+            std::vector<Mark> marks;
+            bool pending = false;
+
+            // Recorded before clearHistory(), read back only to free the pool
+            bool discarded = false;
+        };
+
+        std::size_t historyLength;
+        std::vector<Scope> scopes;
+        FrameQueries frames[FRAME_LATENCY];
+
+        int current = FRAME_LATENCY - 1;
+        bool recording = false;
+        unsigned int dropped = 0;
+
+        void mark(unsigned int scope, bool begin);
+
+        // Read back one frame into the scopes' histories, false if it isn't finished yet
+        // With wait it blocks until the frame is finished instead
+        bool readBack(FrameQueries &queries, bool wait = false);
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include "obHeadless.h"
+#include "obGLState.h"
+#include "obShaderCompiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stb_image.h>
+
+#ifdef OB_HEADLESS
+// Keep the X11 headers, and their macros, out of a build that never talks to a display
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+namespace {
+    void printUsage() {
+        std::cout << "Usage: obelisk --headless [--frames N] [--size WIDTHxHEIGHT] [--capture-every N]\n"
+                     "                          [--dump DIRECTORY] [--compare DIRECTORY] [--tolerance T] [--indirect]\n"
+                     "  --frames N          frames to render (300)\n"
+                     "  --size WxH          framebuffer size (1280x720)\n"
+                     "  --capture-every N   capture every Nth frame instead of only the last\n"
+                     "  --dump DIRECTORY    write captured frames as frame_NNNN.ppm\n"
+                     "  --compare DIRECTORY compare captured frames against DIRECTORY/frame_NNNN.ppm (or .png)\n"
+                     "  --tolerance T       mean difference per channel (0-255) a frame may have (1.0)\n"
+                     "  --indirect          draw through the indirect renderer" << std::endl;
+    }
+
+    bool parseInt(const char* text, int minimum, int &value) {
+        char* end = nullptr;
+        const long parsed = std::strtol(text, &end, 10);
+        if (end == text || *end != '\0' || parsed < minimum || parsed > 1 << 20) {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+}
+
+bool parseHeadlessOptions(int argc, char* argv[], HeadlessOptions &options) {
+    for (int i = 0; i < argc; i++) {
+        const std::string option = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool valid = true;
+        if (option == "--indirect") {
+            options.indirect = true;
+            continue;
+        } else if (value == nullptr) {
+            valid = false;
+        } else if (option == "--frames") {
+            valid = parseInt(value, 1, options.frames);
+        } else if (option == "--size") {
+            const char* separator = std::strchr(value, 'x');
+            valid = separator != nullptr &&
+                    parseInt(std::string(value, separator).c_str(), 1, options.width) &&
+                    parseInt(separator + 1, 1, options.height);
+        } else if (option == "--capture-every") {
+            valid = parseInt(value, 0, options.captureInterval);
+        } else if (option == "--dump") {
+            options.dumpDirectory = value;
+        } else if (option == "--compare") {
+            options.referenceDirectory = value;
+        } else if (option == "--tolerance") {
+            char* end = nullptr;
+            options.tolerance = std::strtof(value, &end);
+            valid = end != value && *end == '\0' && options.tolerance >= 0.0f;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "ERROR::HEADLESS::BAD_OPTION --> " << option << (value ? std::string(" ") + value : "") << std::endl;
+            printUsage();
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+#ifdef OB_HEADLESS
+struct HeadlessContext::Egl {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLConfig config = nullptr;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+};
+
+namespace {
+    // Newest core profile the driver gives us, 4.1 is all the renderer needs
+    EGLContext createContext(EGLDisplay display, EGLConfig config, EGLContext share) {
+        const EGLint versions[][2] = {{4, 6}, {4, 1}};
+        for (const EGLint* version : versions) {
+            const EGLint attributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, version[0],
+                EGL_CONTEXT_MINOR_VERSION, version[1],
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+            EGLContext context = eglCreateContext(display, config, share, attributes);
+            if (context != EGL_NO_CONTEXT) {
+                return context;
+            }
+        }
+        return EGL_NO_CONTEXT;
+    }
+
+    // Make a context current without a surface if the driver allows it, otherwise on a tiny pbuffer
+    // surface receives the pbuffer, which the caller destroys, or EGL_NO_SURFACE
+    bool makeCurrent(EGLDisplay display, EGLConfig config, EGLContext context, EGLSurface &surface) {
+        surface = EGL_NO_SURFACE;
+        if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            return true;
+        }
+        const EGLint attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, attributes);
+        return surface != EGL_NO_SURFACE && eglMakeCurrent(display, surface, surface, context);
+    }
+}
+
+HeadlessContext::HeadlessContext() : egl(new Egl) {
+    // Mesa's surfaceless platform needs no display server, fall back to the default display elsewhere
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        egl->display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (egl->display == EGL_NO_DISPLAY || !eglInitialize(egl->display, nullptr, nullptr)) {
+        egl->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (egl->display == EGL_NO_DISPLAY || !eglInitialize(egl->display, nullptr, nullptr)) {
+            std::cerr << "ERROR::HEADLESS::EGL --> no display could be initialized" << std::endl;
+            egl->display = EGL_NO_DISPLAY;
+            return;
+        }
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLint configCount = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(egl->display, configAttributes, &egl->config, 1, &configCount) ||
+        configCount == 0) {
+        std::cerr << "ERROR::HEADLESS::EGL --> no desktop OpenGL config" << std::endl;
+        return;
+    }
+    egl->context = createContext(egl->display, egl->config, EGL_NO_CONTEXT);
+    if (egl->context == EGL_NO_CONTEXT) {
+        std::cerr << "ERROR::HEADLESS::EGL --> could not create an OpenGL 4.1 core context" << std::endl;
+        return;
+    }
+    if (!makeCurrent(egl->display, egl->config, egl->context, egl->surface)) {
+        std::cerr << "ERROR::HEADLESS::EGL --> could not make the context current" << std::endl;
+        eglDestroyContext(egl->display, egl->context);
+        egl->context = EGL_NO_CONTEXT;
+        return;
+    }
+
+    // The shader worker can't make an sf::Context without a display, it gets a context shared with ours instead
+    const Egl shared = *egl;
+    setShaderWorkerContext([shared]() -> std::function<void()> {
+        // The bound API is per thread
+        eglBindAPI(EGL_OPENGL_API);
+        EGLContext context = createContext(shared.display, shared.config, shared.context);
+        EGLSurface surface = EGL_NO_SURFACE;
+        if (context == EGL_NO_CONTEXT || !makeCurrent(shared.display, shared.config, context, surface)) {
+            std::cerr << "ERROR::HEADLESS::EGL --> could not create the shader worker's context" << std::endl;
+        }
+        return [shared, context, surface]() {
+            eglMakeCurrent(shared.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (surface != EGL_NO_SURFACE) {
+                eglDestroySurface(shared.display, surface);
+            }
+            if (context != EGL_NO_CONTEXT) {
+                eglDestroyContext(shared.display, context);
+            }
+        };
+    });
+}
+
+HeadlessContext::~HeadlessContext() {
+    if (egl->context != EGL_NO_CONTEXT) {
+        if (framebuffer != 0) {
+            GLState::deleteFramebuffers(1, &framebuffer);
+            GLState::deleteRenderbuffers(1, &color);
+        }
+        eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (egl->surface != EGL_NO_SURFACE) {
+            eglDestroySurface(egl->display, egl->surface);
+        }
+        eglDestroyContext(egl->display, egl->context);
+    }
+    if (egl->display != EGL_NO_DISPLAY) {
+        eglTerminate(egl->display);
+    }
+}
+
+bool HeadlessContext::isValid() const {
+    return egl->context != EGL_NO_CONTEXT;
+}
+
+void* HeadlessContext::getFunction(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+#else
+struct HeadlessContext::Egl {};
+
+HeadlessContext::HeadlessContext() : egl(new Egl) {
+    std::cerr << "ERROR::HEADLESS::UNSUPPORTED --> this build has no EGL, headless runs need it" << std::endl;
+}
+
+HeadlessContext::~HeadlessContext() {}
+
+bool HeadlessContext::isValid() const {
+    return false;
+}
+
+void* HeadlessContext::getFunction(const char*) {
+    return nullptr;
+}
+#endif
+
+GLuint HeadlessContext::createFramebuffer(int width, int height) {
+    this->width = width;
+    this->height = height;
+    glGenRenderbuffers(1, &color);
+    GLState::bindRenderbuffer(color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    GLState::bindRenderbuffer(0);
+    glGenFramebuffers(1, &framebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::HEADLESS::FRAMEBUFFER --> " << width << "x" << height << " target is incomplete" << std::endl;
+    }
+    return framebuffer;
+}
+
+void HeadlessContext::readPixels(std::vector<unsigned char> &rgb) const {
+    const std::size_t rowSize = static_cast<std::size_t>(width) * 3;
+    rgb.resize(rowSize * height);
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+
+    // GL reads bottom row first
+    std::vector<unsigned char> row(rowSize);
+    for (int y = 0; y < height / 2; y++) {
+        unsigned char* top = rgb.data() + y * rowSize;
+        unsigned char* bottom = rgb.data() + (height - 1 - y) * rowSize;
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+}
+
+int HeadlessContext::getWidth() const {
+    return width;
+}
+
+int HeadlessContext::getHeight() const {
+    return height;
+}
+
+namespace {
+    // Scene time per frame, see HeadlessRun::getSceneSeconds
+    const float FRAME_SECONDS = 1.0f / 60.0f;
+
+    // Frames left out of the statistics, the first ones pay for driver warm up and their GPU times can be junk
+    const int WARM_UP_FRAMES = 5;
+
+    void printSummary(const char* name, const TimingSummary &summary) {
+        std::printf("%s ms: mean %.3f, min %.3f, median %.3f, p95 %.3f, p99 %.3f, max %.3f\n", name,
+                    summary.mean, summary.min, summary.median, summary.p95, summary.p99, summary.max);
+    }
+}
+
+HeadlessRun::HeadlessRun(const HeadlessOptions &options, HeadlessContext &context, GpuProfiler &profiler)
+    : options(options), context(context), profiler(profiler) {
+    if (!options.dumpDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(options.dumpDirectory, error);
+    }
+    frameTimes.reserve(options.frames);
+}
+
+bool HeadlessRun::isRunning() const {
+    return frame < options.frames;
+}
+
+float HeadlessRun::getSceneSeconds() const {
+    return frame * FRAME_SECONDS;
+}
+
+void HeadlessRun::endFrame(float frameMilliseconds) {
+    // Short runs keep every frame rather than have nothing to report
+    const bool timed = frame >= WARM_UP_FRAMES || options.frames <= 2 * WARM_UP_FRAMES;
+    if (timed) {
+        frameTimes.push_back(frameMilliseconds);
+    } else if (frame + 1 == WARM_UP_FRAMES) {
+        profiler.clearHistory();
+    }
+
+    const bool lastFrame = frame + 1 == options.frames;
+    const bool intervalFrame = options.captureInterval > 0 && frame % options.captureInterval == 0;
+    if ((lastFrame || intervalFrame) && !(options.dumpDirectory.empty() && options.referenceDirectory.empty())) {
+        captureFrame();
+    }
+    frame++;
+}
+
+void HeadlessRun::captureFrame() {
+    context.readPixels(capture);
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%04d", frame);
+
+    if (!options.dumpDirectory.empty()) {
+        writePPM(options.dumpDirectory + "/" + name + ".ppm", context.getWidth(), context.getHeight(), capture);
+    }
+
+    if (!options.referenceDirectory.empty()) {
+        std::string reference = options.referenceDirectory + "/" + name + ".ppm";
+        if (!std::filesystem::exists(reference)) {
+            reference = options.referenceDirectory + "/" + name + ".png";
+        }
+        float meanError = 0.0f;
+        int maxError = 0;
+        comparedFrames++;
+        if (!compareImage(reference, context.getWidth(), context.getHeight(), capture, meanError, maxError)) {
+            mismatchedFrames++;
+            return;
+        }
+        const bool matches = meanError <= options.tolerance;
+        if (!matches) {
+            mismatchedFrames++;
+        }
+        std::printf("%s: mean error %.3f, max error %d%s\n", name, meanError, maxError, matches ? "" : " MISMATCH");
+    }
+}
+
+int HeadlessRun::finish() const {
+    TimingSummary cpu = summarizeTimes(frameTimes);
+    std::printf("Rendered %d frames, %zu timed, %.1f fps\n", frame, frameTimes.size(), cpu.mean > 0.0f ? 1000.0f / cpu.mean : 0.0f);
+    printSummary("CPU frame", cpu);
+    for (unsigned int scope = 0; scope < profiler.getScopeCount(); scope++) {
+        printSummary(("GPU " + profiler.getName(scope)).c_str(), profiler.getSummary(scope));
+    }
+    if (comparedFrames > 0) {
+        std::printf("%d of %d frames match their references\n", comparedFrames - mismatchedFrames, comparedFrames);
+    }
+    std::fflush(stdout);
+    return mismatchedFrames > 0 ? 1 : 0;
+}
+
+bool writePPM(const std::string &path, int width, int height, const std::vector<unsigned char> &rgb) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR::HEADLESS::WRITE --> could not open " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+    return static_cast<bool>(file);
+}
+
+bool compareImage(const std::string &referencePath, int width, int height, const std::vector<unsigned char> &rgb,
+                  float &meanError, int &maxError) {
+    // Captures are top row first, as stb_image loads
+    stbi_set_flip_vertically_on_load(false);
+    int referenceWidth = 0, referenceHeight = 0, channels = 0;
+    unsigned char* reference = stbi_load(referencePath.c_str(), &referenceWidth, &referenceHeight, &channels, 3);
+    if (!reference) {
+        std::cerr << "ERROR::HEADLESS::COMPARE --> could not load " << referencePath << std::endl;
+        return false;
+    }
+    const bool sameSize = referenceWidth == width && referenceHeight == height && rgb.size() == static_cast<std::size_t>(width) * height * 3;
+    if (!sameSize) {
+        std::cerr << "ERROR::HEADLESS::COMPARE --> " << referencePath << " is " << referenceWidth << "x" << referenceHeight
+                  << ", the frame is " << width << "x" << height << std::endl;
+    } else {
+        double total = 0.0;
+        maxError = 0;
+        for (std::size_t i = 0; i < rgb.size(); i++) {
+            const int difference = std::abs(static_cast<int>(rgb[i]) - static_cast<int>(reference[i]));
+            total += difference;
+            maxError = std::max(maxError, difference);
+        }
+        meanError = rgb.empty() ? 0.0f : static_cast<float>(total / rgb.size());
+    }
+    stbi_image_free(reference);
+    return sameSize;
+}
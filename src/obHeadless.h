@@ -0,0 +1,121 @@
+#ifndef OBHEADLESS_H
+#define OBHEADLESS_H
+
+#include "obGpuProfiler.h"
+
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Running without a window (--headless), for benchmarks and golden image tests on machines with no display or GPU
+// The scene renders into an offscreen framebuffer with no vsync or frame cap, following a scripted camera path,
+// and the run ends by printing frame time statistics
+
+// Settings of a headless run, given on the command line after --headless
+struct HeadlessOptions {
+    int frames = 300;
+    int width = 1280;
+    int height = 720;
+
+    // Capture every captureInterval-th frame, 0 captures only the last one
+    int captureInterval = 0;
+
+    // Write captured frames here as frame_NNNN.ppm
+    std::string dumpDirectory;
+
+    // Compare captured frames against the images of the same name here (PPM or PNG)
+    std::string referenceDirectory;
+
+    // Largest mean difference per channel (0-255) a frame may have from its reference
+    float tolerance = 1.0f;
+
+    // Draw the lit objects through the indirect renderer
+    bool indirect = false;
+};
+
+// Parse the arguments following --headless, prints the usage and returns false on a bad one
+bool parseHeadlessOptions(int argc, char* argv[], HeadlessOptions &options);
+
+// An OpenGL context with no window or display, from EGL on Mesa's surfaceless platform (so llvmpipe works too)
+// Frames go into a framebuffer it owns instead of a window's
+// Only available where EGL was found at build time (OB_HEADLESS), elsewhere isValid() is always false
+class HeadlessContext {
+    public:
+        // Create the context and make it current, also gives the shader worker a context sharing with it
+        HeadlessContext();
+        ~HeadlessContext();
+
+        HeadlessContext(const HeadlessContext &) = delete;
+        HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+        bool isValid() const;
+
+        // GL function loader for gladLoadGLLoader and initShaderCompiler
+        static void* getFunction(const char* name);
+
+        // Create the framebuffer standing in for a window's and return it, call once GL is loaded
+        GLuint createFramebuffer(int width, int height);
+
+        // Read the framebuffer back as tightly packed RGB rows, top row first
+        void readPixels(std::vector<unsigned char> &rgb) const;
+
+        int getWidth() const;
+        int getHeight() const;
+
+    private:
+        // EGL handles, kept out of the header so its platform headers don't leak everywhere
+        struct Egl;
+        std::unique_ptr<Egl> egl;
+
+        GLuint framebuffer = 0;
+        GLuint color = 0;
+        int width = 0;
+        int height = 0;
+};
+
+// Drives a headless run frame by frame: counts frames, times them, captures and checks the chosen ones
+class HeadlessRun {
+    public:
+        // Creates the dump directory if there is one
+        // The profiler's scopes are reported at the end, its history should cover every frame
+        HeadlessRun(const HeadlessOptions &options, HeadlessContext &context, GpuProfiler &profiler);
+
+        // Whether there are frames left to render
+        bool isRunning() const;
+
+        // Scene time of the current frame, advancing a fixed 1/60 s per frame whatever the real frame rate,
+        // so the same frame always shows the same image
+        float getSceneSeconds() const;
+
+        // Call once the frame is in the context's framebuffer, with the CPU time the frame took in milliseconds
+        void endFrame(float frameMilliseconds);
+
+        // Print the CPU and per scope GPU timing statistics, leaving out the first few frames, and the comparison results
+        // Returns the process exit code, nonzero if a frame didn't match its reference
+        int finish() const;
+
+    private:
+        const HeadlessOptions options;
+        HeadlessContext &context;
+        GpuProfiler &profiler;
+
+        int frame = 0;
+        std::vector<float> frameTimes;
+        std::vector<unsigned char> capture;
+        int comparedFrames = 0;
+        int mismatchedFrames = 0;
+
+        void captureFrame();
+};
+
+// Write an RGB image, rows top first, as a binary PPM, returns false if the file can't be written
+bool writePPM(const std::string &path, int width, int height, const std::vector<unsigned char> &rgb);
+
+// Compare an RGB image against a reference image file of the same size
+// Returns false if the reference can't be loaded or its size differs, otherwise
+// meanError is the mean absolute difference per channel and maxError the largest one
+bool compareImage(const std::string &referencePath, int width, int height, const std::vector<unsigned char> &rgb,
+                  float &meanError, int &maxError);
+
+#endif
@@ -0,0 +1,142 @@
+#include "obIndirectRenderer.h"
+#include "obGLState.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Starting size of a frame's instances and commands, enough for a few thousand draws
+    const std::size_t INITIAL_STREAM_BYTES = 256 * 1024;
+}
+
+IndirectRenderer::IndirectRenderer() : stream(INITIAL_STREAM_BYTES) {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FLOATS_PER_VERTEX * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    GLState::bindVertexArray(0);
+
+#ifndef IS_MACOS
+    multiDraw = GLAD_GL_VERSION_4_3 != 0;
+#endif
+}
+
+IndirectRenderer::~IndirectRenderer() {
+    GLState::deleteBuffers(1, &EBO);
+    GLState::deleteBuffers(1, &VBO);
+    GLState::deleteVertexArrays(1, &VAO);
+}
+
+unsigned int IndirectRenderer::addMesh(const MeshBuilder &mesh) {
+    if (mesh.getFloatsPerVertex() != FLOATS_PER_VERTEX) {
+        std::cerr << "ERROR::INDIRECT::VERTEX_LAYOUT --> mesh has " << mesh.getFloatsPerVertex()
+                  << " floats per vertex, expected " << FLOATS_PER_VERTEX << std::endl;
+        return 0;
+    }
+    // Indices stay relative to the mesh, baseVertex moves them to its vertices
+    meshes.push_back({static_cast<GLuint>(indices.size()), static_cast<GLuint>(mesh.getIndices().size()),
+                      static_cast<GLint>(vertices.size() / FLOATS_PER_VERTEX)});
+    vertices.insert(vertices.end(), mesh.getVertices().begin(), mesh.getVertices().end());
+    indices.insert(indices.end(), mesh.getIndices().begin(), mesh.getIndices().end());
+    meshesDirty = true;
+    return static_cast<unsigned int>(meshes.size() - 1);
+}
+
+void IndirectRenderer::addDraw(unsigned int mesh, const glm::mat4 &model, std::uint32_t materialID) {
+    if (mesh >= meshes.size()) {
+        return;
+    }
+    queue.push_back({mesh, model, materialID});
+}
+
+bool IndirectRenderer::isMultiDrawSupported() const {
+    return multiDraw;
+}
+
+unsigned int IndirectRenderer::getSubmittedDraws() const {
+    return submittedDraws;
+}
+
+unsigned int IndirectRenderer::getSubmittedCalls() const {
+    return submittedCalls;
+}
+
+void IndirectRenderer::submit() {
+    submittedDraws = static_cast<unsigned int>(queue.size());
+    submittedCalls = 0;
+    if (queue.empty()) {
+        return;
+    }
+
+    // Bind our vertex array first, the element buffer binding belongs to whichever one is bound
+    GLState::bindVertexArray(VAO);
+    if (meshesDirty) {
+        GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+        meshesDirty = false;
+    }
+
+    // One command per mesh with copies queued, its instances stored contiguously from baseInstance
+    meshCursors.assign(meshes.size(), 0);
+    for (const QueuedDraw &draw : queue) {
+        meshCursors[draw.mesh]++;
+    }
+    commands.clear();
+    GLuint nextInstance = 0;
+    for (std::size_t mesh = 0; mesh < meshes.size(); mesh++) {
+        const GLuint copies = meshCursors[mesh];
+        if (copies == 0) {
+            continue;
+        }
+        commands.push_back({meshes[mesh].indexCount, copies, meshes[mesh].firstIndex, meshes[mesh].baseVertex, nextInstance});
+        meshCursors[mesh] = nextInstance;
+        nextInstance += copies;
+    }
+
+    // Room for this frame's instances and commands, in the stream's next region
+    using Instance = InstanceBuffer::Instance;
+    const std::size_t instanceBytes = nextInstance * sizeof(Instance);
+    const std::size_t commandBytes = commands.size() * sizeof(DrawCommand);
+    stream.beginFrame(instanceBytes + alignof(DrawCommand) + commandBytes);
+    std::size_t instanceOffset = 0;
+    Instance* instances = static_cast<Instance*>(stream.allocate(instanceBytes, alignof(Instance), instanceOffset));
+
+    // Scatter the queue into mesh order, straight into the stream
+    for (const QueuedDraw &draw : queue) {
+        instances[meshCursors[draw.mesh]++] = {draw.model, draw.materialID};
+    }
+    queue.clear();
+
+#ifndef IS_MACOS
+    if (multiDraw) {
+        std::size_t commandOffset = 0;
+        void* commandData = stream.allocate(commandBytes, alignof(DrawCommand), commandOffset);
+        std::memcpy(commandData, commands.data(), commandBytes);
+        stream.flush();
+        InstanceBuffer::attachBuffer(VAO, stream.ID, instanceOffset);
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.ID);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandOffset, static_cast<GLsizei>(commands.size()), 0);
+        stream.endFrame();
+        submittedCalls = 1;
+        return;
+    }
+#endif
+    // Without base instances the instance attributes themselves are moved to each command's range
+    stream.flush();
+    for (const DrawCommand &command : commands) {
+        InstanceBuffer::attachBuffer(VAO, stream.ID, instanceOffset + command.baseInstance * sizeof(Instance));
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                          (void*)(command.firstIndex * sizeof(std::uint32_t)), command.instanceCount, command.baseVertex);
+        submittedCalls++;
+    }
+    stream.endFrame();
+}
@@ -0,0 +1,92 @@
+#ifndef OBINDIRECTRENDERER_H
+#define OBINDIRECTRENDERER_H
+
+#include "obInstances.h"
+#include "obMeshBuilder.h"
+#include "obStreamBuffer.h"
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Packs every mesh into one shared vertex and index buffer and submits a whole scene as indirect draws
+// Copies of one mesh become one command, and all commands go out in a single glMultiDrawElementsIndirect
+// Draw with a shader compiled with INSTANCED: each command's baseInstance points at its range of the
+// instance buffer, which is how the shader fetches per draw data without gl_DrawID (GL 4.6)
+// Instances and commands are rewritten every submit(), so they are streamed through a StreamBuffer
+class IndirectRenderer {
+    public:
+        // Meshes have a position and a normal per vertex, the layout basic.vert reads
+        static constexpr int FLOATS_PER_VERTEX = 6;
+
+        IndirectRenderer();
+        ~IndirectRenderer();
+
+        IndirectRenderer(const IndirectRenderer &) = delete;
+        IndirectRenderer &operator=(const IndirectRenderer &) = delete;
+
+        // Copy a mesh into the shared buffers and return its ID for addDraw()
+        unsigned int addMesh(const MeshBuilder &mesh);
+
+        // Queue one copy of a mesh for the next submit()
+        void addDraw(unsigned int mesh, const glm::mat4 &model, std::uint32_t materialID);
+
+        // Draw everything queued with the bound program, then empty the queue
+        // Each call uses the stream's next region, so call it once per frame
+        void submit();
+
+        // Whether submit() uses glMultiDrawElementsIndirect (GL 4.3)
+        // Without it, e.g. on macOS, each command is its own instanced draw call
+        bool isMultiDrawSupported() const;
+
+        // Objects drawn and GL draw calls issued by the last submit()
+        unsigned int getSubmittedDraws() const;
+        unsigned int getSubmittedCalls() const;
+
+    private:
+        // Layout glMultiDrawElementsIndirect reads from the command buffer
+        struct DrawCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        // Where a mesh lives in the shared buffers
+        struct MeshRange {
+            GLuint firstIndex;
+            GLuint indexCount;
+            GLint baseVertex;
+        };
+
+        struct QueuedDraw {
+            unsigned int mesh;
+            glm::mat4 model;
+            std::uint32_t materialID;
+        };
+
+        unsigned int VAO;
+        unsigned int VBO;
+        unsigned int EBO;
+        StreamBuffer stream;
+
+        // Every mesh's data, uploaded again on the next submit() after a mesh is added
+        std::vector<float> vertices;
+        std::vector<std::uint32_t> indices;
+        bool meshesDirty = false;
+        std::vector<MeshRange> meshes;
+
+        std::vector<QueuedDraw> queue;
+        std::vector<DrawCommand> commands;
+
+        // Where each mesh's instances start while building the commands
+        std::vector<GLuint> meshCursors;
+
+        bool multiDraw = false;
+        unsigned int submittedDraws = 0;
+        unsigned int submittedCalls = 0;
+};
+
+#endif
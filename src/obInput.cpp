@@ -0,0 +1,136 @@
+#include "obInput.h"
+
+#include <chrono>
+#include <iostream>
+
+// Only Windows reads the keyboard and mouse (GetAsyncKeyState, GetCursorPos) in a way that is safe from any thread
+// On X11 sf::Keyboard and sf::Mouse go through the Display connection the main thread polls events on,
+// and macOS only allows input on the main thread, so everywhere else the queues are fed from window events
+#ifdef _WIN32
+#define OB_INPUT_THREAD
+#endif
+
+namespace {
+    const std::chrono::microseconds SAMPLE_INTERVAL(1000);
+}
+
+InputSampler::InputSampler(const sf::Window &window, const std::vector<sf::Keyboard::Scancode> keys)
+    : window(window), keys(keys), sampledDown(keys.size(), false), lastMousePosition(sf::Mouse::getPosition(window)) {
+#ifdef OB_INPUT_THREAD
+    running = true;
+    thread = std::thread(&InputSampler::sample, this);
+#endif
+}
+
+InputSampler::~InputSampler() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+std::int64_t InputSampler::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void InputSampler::setEnabled(bool enabled) {
+    this->enabled = enabled;
+#ifndef OB_INPUT_THREAD
+    // There is no sampling thread to notice, release everything right away
+    if (!enabled) {
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            pushKey(i, false, now());
+        }
+    } else {
+        lastMousePosition = sf::Mouse::getPosition(window);
+    }
+#endif
+}
+
+void InputSampler::pushKey(std::size_t index, bool down, std::int64_t time) {
+    if (sampledDown[index] == down) {
+        return;
+    }
+    if (!keyEvents.push({time, keys[index], down})) {
+        std::cerr << "ERROR::INPUT::KEY_QUEUE_FULL" << std::endl;
+        return;
+    }
+    sampledDown[index] = down;
+}
+
+void InputSampler::sample() {
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    while (running) {
+        const std::int64_t time = now();
+        const bool isEnabled = enabled;
+
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            pushKey(i, isEnabled && sf::Keyboard::isKeyPressed(keys[i]), time);
+        }
+
+        // Start over from the current position on refocus, instead of turning the jump into a rotation
+        const sf::Vector2i position = sf::Mouse::getPosition(window);
+        if (isEnabled && wasEnabled && position != lastMousePosition) {
+            const sf::Vector2i delta = position - lastMousePosition;
+            mouseEvents.push({time, glm::vec2(delta.x, delta.y)});
+        }
+        lastMousePosition = position;
+        wasEnabled = isEnabled;
+
+        next += SAMPLE_INTERVAL;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void InputSampler::feed(const sf::Event &event) {
+#ifndef OB_INPUT_THREAD
+    if (!enabled) {
+        return;
+    }
+    const std::int64_t time = now();
+    if (const auto* key = event.getIf<sf::Event::KeyPressed>()) {
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key->scancode) {
+                pushKey(i, true, time);
+            }
+        }
+    } else if (const auto* key = event.getIf<sf::Event::KeyReleased>()) {
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key->scancode) {
+                pushKey(i, false, time);
+            }
+        }
+    } else if (const auto* moved = event.getIf<sf::Event::MouseMoved>()) {
+        const sf::Vector2i delta = moved->position - lastMousePosition;
+        lastMousePosition = moved->position;
+        mouseEvents.push({time, glm::vec2(delta.x, delta.y)});
+    }
+#else
+    (void)event;
+#endif
+}
+
+void InputSampler::consumeKeysUntil(std::int64_t time) {
+    for (const KeyEvent* event = keyEvents.front(); event && event->time <= time; event = keyEvents.front()) {
+        keyState[static_cast<std::size_t>(event->key)] = event->down;
+        keyEvents.pop();
+    }
+}
+
+bool InputSampler::isKeyDown(sf::Keyboard::Scancode key) const {
+    return keyState[static_cast<std::size_t>(key)];
+}
+
+glm::vec2 InputSampler::takeMouseDelta() {
+    glm::vec2 delta(0.0f);
+    for (const MouseEvent* event = mouseEvents.front(); event; event = mouseEvents.front()) {
+        delta += event->delta;
+        mouseTime = event->time;
+        mouseEvents.pop();
+    }
+    return delta;
+}
+
+std::int64_t InputSampler::getMouseTime() const {
+    return mouseTime;
+}
@@ -0,0 +1,87 @@
+#ifndef OBINPUT_H
+#define OBINPUT_H
+
+#include "obSpscQueue.h"
+
+#include <SFML/Window.hpp>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Samples keyboard and mouse on its own thread, about once a millisecond, instead of once per frame
+// Changes are queued with timestamps, the simulation replays key changes up to each step's time and
+// the mouse movement is taken as late as possible in the frame (late latching)
+// Only on Windows is sampling from another thread safe, elsewhere the queues are fed from the window's events instead
+class InputSampler {
+    public:
+        // Start sampling the given keys and the mouse position relative to window
+        InputSampler(const sf::Window &window, const std::vector<sf::Keyboard::Scancode> keys);
+        ~InputSampler();
+
+        InputSampler(const InputSampler &) = delete;
+        InputSampler &operator=(const InputSampler &) = delete;
+
+        // Microseconds on the clock the events are stamped with
+        static std::int64_t now();
+
+        // Ignore input while the window is unfocused, held keys are released when disabled
+        void setEnabled(bool enabled);
+
+        // Pass every window event through here, only used where input can't be sampled on another thread (not Windows)
+        void feed(const sf::Event &event);
+
+        // Apply every key change stamped at or before time to the key state table
+        void consumeKeysUntil(std::int64_t time);
+
+        // Whether a key was down as of the last consumeKeysUntil()
+        bool isKeyDown(sf::Keyboard::Scancode key) const;
+
+        // All mouse movement (in pixels) since the last call
+        glm::vec2 takeMouseDelta();
+
+        // When the newest movement returned by takeMouseDelta() was sampled, e.g. to measure input to photon latency
+        std::int64_t getMouseTime() const;
+
+    private:
+        struct KeyEvent {
+            std::int64_t time;
+            sf::Keyboard::Scancode key;
+            bool down;
+        };
+
+        struct MouseEvent {
+            std::int64_t time;
+            glm::vec2 delta;
+        };
+
+        const sf::Window &window;
+        std::vector<sf::Keyboard::Scancode> keys;
+
+        // Written by the producer only, which is the sampling thread or, off Windows, feed()
+        SpscQueue<KeyEvent, 1024> keyEvents;
+        SpscQueue<MouseEvent, 1024> mouseEvents;
+
+        // Read by the consumer only
+        std::bitset<sf::Keyboard::ScancodeCount> keyState;
+        std::int64_t mouseTime = 0;
+
+        std::atomic<bool> enabled{true};
+        std::atomic<bool> running{false};
+        std::thread thread;
+
+        // Producer state, the keys seen down and the mouse position of the last sample
+        std::vector<bool> sampledDown;
+        sf::Vector2i lastMousePosition;
+        bool wasEnabled = true;
+
+        // Sampling thread body
+        void sample();
+
+        // Queue a key change if it differs from the last sample
+        void pushKey(std::size_t index, bool down, std::int64_t time);
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "obInstances.h"
+#include "obGLState.h"
+
+#include <algorithm>
+#include <cstddef>
+
+InstanceBuffer::InstanceBuffer() {
+    glGenBuffers(1, &ID);
+}
+
+InstanceBuffer::~InstanceBuffer() {
+    GLState::deleteBuffers(1, &ID);
+}
+
+void InstanceBuffer::attach(unsigned int VAO, GLuint firstInstance) const {
+    attachBuffer(VAO, ID, firstInstance * sizeof(Instance));
+}
+
+void InstanceBuffer::attachBuffer(unsigned int VAO, unsigned int buffer, std::size_t offset) {
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; column++) {
+        const std::size_t columnOffset = offset + offsetof(Instance, model) + column * sizeof(glm::vec4);
+        glVertexAttribPointer(MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)columnOffset);
+        glEnableVertexAttribArray(MODEL_LOCATION + column);
+        glVertexAttribDivisor(MODEL_LOCATION + column, 1);
+    }
+    // Integer attributes need the I variant, or they arrive converted to float
+    glVertexAttribIPointer(MATERIAL_LOCATION, 1, GL_UNSIGNED_INT, sizeof(Instance), (void*)(offset + offsetof(Instance, materialID)));
+    glEnableVertexAttribArray(MATERIAL_LOCATION);
+    glVertexAttribDivisor(MATERIAL_LOCATION, 1);
+}
+
+std::uint32_t InstanceBuffer::add(const glm::mat4 &model, std::uint32_t materialID) {
+    instances.push_back({model, materialID});
+    const std::uint32_t index = static_cast<std::uint32_t>(instances.size() - 1);
+    markDirty(index);
+    return index;
+}
+
+void InstanceBuffer::set(std::uint32_t index, const glm::mat4 &model, std::uint32_t materialID) {
+    if (index >= instances.size()) {
+        return;
+    }
+    instances[index] = {model, materialID};
+    markDirty(index);
+}
+
+void InstanceBuffer::setModel(std::uint32_t index, const glm::mat4 &model) {
+    if (index >= instances.size()) {
+        return;
+    }
+    instances[index].model = model;
+    markDirty(index);
+}
+
+GLsizei InstanceBuffer::size() const {
+    return static_cast<GLsizei>(instances.size());
+}
+
+void InstanceBuffer::clear() {
+    instances.clear();
+    dirtyBegin = dirtyEnd = 0;
+}
+
+void InstanceBuffer::resize(std::size_t count) {
+    instances.resize(count, {glm::mat4(1.0f), 0});
+    dirtyBegin = std::min(dirtyBegin, count);
+    dirtyEnd = std::min(dirtyEnd, count);
+}
+
+void InstanceBuffer::markDirty(std::size_t index) {
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = index;
+        dirtyEnd = index + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, index + 1);
+    }
+}
+
+void InstanceBuffer::upload() {
+    if (dirtyBegin == dirtyEnd) {
+        return;
+    }
+    GLState::bindBuffer(GL_ARRAY_BUFFER, ID);
+    if (instances.size() > capacity) {
+        // Grow geometrically and send everything, the old contents don't carry over
+        capacity = std::max(instances.size(), capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), NULL, GL_DYNAMIC_DRAW);
+        dirtyBegin = 0;
+        dirtyEnd = instances.size();
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, dirtyBegin * sizeof(Instance), (dirtyEnd - dirtyBegin) * sizeof(Instance), &instances[dirtyBegin]);
+    dirtyBegin = dirtyEnd = 0;
+}
@@ -0,0 +1,74 @@
+#ifndef OBINSTANCES_H
+#define OBINSTANCES_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Per instance data for drawing many copies of one mesh with a single instanced draw call
+// Shaders compiled with INSTANCED read it in place of the model and materialID uniforms (see shaders/transform.glsl)
+class InstanceBuffer {
+    public:
+        // Attribute locations of the instance data, must match shaders/transform.glsl
+        // A mat4 attribute takes one location per column
+        static constexpr GLuint MODEL_LOCATION = 3;
+        static constexpr GLuint MATERIAL_LOCATION = 7;
+
+        // The vertex buffer holding the instances
+        unsigned int ID;
+
+        InstanceBuffer();
+        ~InstanceBuffer();
+
+        InstanceBuffer(const InstanceBuffer &) = delete;
+        InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+        // Add the instance attributes, advancing once per instance, to a vertex array object
+        // firstInstance offsets where they start reading, for drawing a range without a base instance (GL 4.2)
+        // The vertex array stays bound afterwards
+        void attach(unsigned int VAO, GLuint firstInstance = 0) const;
+
+        // Layout of one instance in the buffer
+        struct Instance {
+            glm::mat4 model;
+            std::uint32_t materialID;
+        };
+
+        // Point a vertex array's instance attributes at instances stored in another buffer from offset (in bytes) on
+        // For instances written straight into a stream, e.g. a StreamBuffer region, the vertex array stays bound afterwards
+        static void attachBuffer(unsigned int VAO, unsigned int buffer, std::size_t offset);
+
+        // Add an instance and return its index
+        std::uint32_t add(const glm::mat4 &model, std::uint32_t materialID);
+
+        // Change an existing instance
+        void set(std::uint32_t index, const glm::mat4 &model, std::uint32_t materialID);
+        void setModel(std::uint32_t index, const glm::mat4 &model);
+
+        // The instance count to pass to glDraw*Instanced
+        GLsizei size() const;
+        void clear();
+
+        // Grow or shrink to count instances, added ones have an identity model and material 0
+        // Fill them in with set() before the next upload
+        void resize(std::size_t count);
+
+        // Upload the instances changed since the last upload, call before drawing
+        void upload();
+
+    private:
+        std::vector<Instance> instances;
+
+        // Instances the buffer has room for, it is reallocated when they no longer fit
+        std::size_t capacity = 0;
+
+        // Range of instances to upload, empty when dirtyBegin == dirtyEnd
+        std::size_t dirtyBegin = 0;
+        std::size_t dirtyEnd = 0;
+
+        void markDirty(std::size_t index);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "obMaterials.h"
+#include "obGLState.h"
+#include "obUniformBlocks.h"
+
+#include <algorithm>
+#include <iostream>
+
+MaterialTable::MaterialTable() {
+    glGenBuffers(1, &UBO);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(Entry), NULL, GL_STATIC_DRAW);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, UBO);
+    entries.reserve(MAX_MATERIALS);
+}
+
+MaterialTable::~MaterialTable() {
+    GLState::deleteBuffers(1, &UBO);
+}
+
+unsigned int MaterialTable::add(const Material &material) {
+    if (entries.size() >= MAX_MATERIALS) {
+        std::cerr << "ERROR::MATERIALS::TABLE_FULL" << std::endl;
+        return 0;
+    }
+    entries.emplace_back();
+    unsigned int id = static_cast<unsigned int>(entries.size() - 1);
+    set(id, material);
+    return id;
+}
+
+void MaterialTable::set(unsigned int id, const Material &material) {
+    if (id >= entries.size()) {
+        return;
+    }
+    Entry &entry = entries[id];
+    entry.ambient = material.ambient;
+    entry.diffuse = material.diffuse;
+    entry.specular = material.specular;
+    entry.shininess = material.shininess;
+
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = id;
+        dirtyEnd = id + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, id);
+        dirtyEnd = std::max(dirtyEnd, id + 1);
+    }
+}
+
+void MaterialTable::upload() {
+    if (dirtyBegin == dirtyEnd) {
+        return;
+    }
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, dirtyBegin * sizeof(Entry), (dirtyEnd - dirtyBegin) * sizeof(Entry), &entries[dirtyBegin]);
+    dirtyBegin = dirtyEnd = 0;
+}
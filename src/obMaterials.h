@@ -0,0 +1,59 @@
+#ifndef OBMATERIALS_H
+#define OBMATERIALS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// A Phong material, see shaders/lighting.glsl
+struct Material {
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+    float shininess;
+};
+
+// Every material lives in one uniform buffer (the MaterialData block in shaders/materials.glsl)
+// Draws pick theirs with a single integer ID instead of setting each material uniform
+class MaterialTable {
+    public:
+        // Must match MAX_MATERIALS in shaders/materials.glsl, 256 entries fit the minimum guaranteed block size
+        static constexpr unsigned int MAX_MATERIALS = 256;
+
+        // Create the buffer and attach it to MATERIAL_BLOCK_BINDING
+        MaterialTable();
+        ~MaterialTable();
+
+        MaterialTable(const MaterialTable &) = delete;
+        MaterialTable &operator=(const MaterialTable &) = delete;
+
+        // Add a material and return its ID, or 0 (the first material) if the table is full
+        unsigned int add(const Material &material);
+
+        // Replace an existing material
+        void set(unsigned int id, const Material &material);
+
+        // Upload the entries changed since the last upload, call before drawing
+        void upload();
+
+    private:
+        // std140 layout of the GLSL Material struct
+        struct Entry {
+            glm::vec3 ambient;
+            float padding0;
+            glm::vec3 diffuse;
+            float padding1;
+            glm::vec3 specular;
+            float shininess;
+        };
+        static_assert(sizeof(Entry) == 48, "Entry must match the std140 layout of Material");
+
+        unsigned int UBO;
+        std::vector<Entry> entries;
+
+        // Range of entries to upload, empty when dirtyBegin == dirtyEnd
+        unsigned int dirtyBegin = 0;
+        unsigned int dirtyEnd = 0;
+};
+
+#endif
@@ -0,0 +1,237 @@
+#include "obMeshBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    // Size of the LRU cache the triangle ordering simulates, larger than real hardware caches
+    // since the scores only need to favour recently used vertices
+    const int CACHE_SIZE = 32;
+
+    // Scoring constants from Forsyth's article
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    // How much using a vertex now is worth, from where it is in the cache (-1 if it isn't)
+    // and how many triangles still need it
+    float vertexScore(int cachePosition, int remainingTriangles) {
+        if (remainingTriangles == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                // Used by the last triangle, a fixed score so the next triangle doesn't just repeat an edge
+                score = LAST_TRIANGLE_SCORE;
+            } else {
+                const float scale = 1.0f / (CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+            }
+        }
+        // Favour vertices with few triangles left so they are finished off and don't linger
+        score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+MeshBuilder::MeshBuilder(int floatsPerVertex) : floatsPerVertex(floatsPerVertex) {}
+
+std::size_t MeshBuilder::hashVertex(const float* vertex) const {
+    // FNV-1a over the vertex's bytes
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertex);
+    std::size_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < floatsPerVertex * sizeof(float); i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void MeshBuilder::addVertex(const float* vertex) {
+    const std::size_t hash = hashVertex(vertex);
+    auto candidates = weldTable.equal_range(hash);
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+        if (std::memcmp(&vertices[candidate->second * floatsPerVertex], vertex, floatsPerVertex * sizeof(float)) == 0) {
+            indices.push_back(candidate->second);
+            return;
+        }
+    }
+
+    const std::uint32_t index = static_cast<std::uint32_t>(getVertexCount());
+    vertices.insert(vertices.end(), vertex, vertex + floatsPerVertex);
+    weldTable.emplace(hash, index);
+    indices.push_back(index);
+}
+
+void MeshBuilder::addVertices(const float* vertices, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        addVertex(vertices + i * floatsPerVertex);
+    }
+}
+
+void MeshBuilder::optimize() {
+    optimizeVertexCache();
+    optimizeVertexFetch();
+}
+
+const std::vector<float> &MeshBuilder::getVertices() const {
+    return vertices;
+}
+
+const std::vector<std::uint32_t> &MeshBuilder::getIndices() const {
+    return indices;
+}
+
+std::size_t MeshBuilder::getVertexCount() const {
+    return vertices.size() / floatsPerVertex;
+}
+
+int MeshBuilder::getFloatsPerVertex() const {
+    return floatsPerVertex;
+}
+
+float MeshBuilder::getACMR(int cacheSize) const {
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // When each vertex last entered the cache, a vertex is still cached if fewer than cacheSize entered since
+    std::vector<std::size_t> enteredAt(getVertexCount(), std::numeric_limits<std::size_t>::max());
+    std::size_t misses = 0;
+    for (std::uint32_t index : indices) {
+        if (enteredAt[index] == std::numeric_limits<std::size_t>::max() || misses - enteredAt[index] >= static_cast<std::size_t>(cacheSize)) {
+            enteredAt[index] = misses;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+void MeshBuilder::optimizeVertexCache() {
+    const std::size_t triangleCount = indices.size() / 3;
+    const std::size_t vertexCount = getVertexCount();
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles using each vertex, packed, with the not yet emitted ones at the front of each vertex's range
+    std::vector<int> remaining(vertexCount, 0);
+    for (std::uint32_t index : indices) {
+        remaining[index]++;
+    }
+    std::vector<std::size_t> adjacencyStart(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; v++) {
+        adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    }
+    std::vector<std::uint32_t> adjacency(indices.size());
+    std::vector<std::size_t> adjacencyFill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (std::size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) {
+            adjacency[adjacencyFill[indices[t * 3 + corner]]++] = static_cast<std::uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> scores(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++) {
+        scores[v] = vertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (std::size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+    }
+
+    std::vector<std::uint32_t> cache;
+    std::vector<std::uint32_t> newCache;
+    std::vector<std::uint32_t> ordered;
+    ordered.reserve(indices.size());
+
+    // Start from the best triangle overall, after that only triangles touching the cache are considered
+    std::size_t best = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+    std::size_t scanCursor = 0;
+    for (std::size_t step = 0; step < triangleCount; step++) {
+        emitted[best] = true;
+        const std::uint32_t* triangle = &indices[best * 3];
+        ordered.insert(ordered.end(), triangle, triangle + 3);
+
+        // The triangle's vertices move to the front of the cache, the rest shift back
+        newCache.assign(triangle, triangle + 3);
+        for (std::uint32_t vertex : cache) {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+                newCache.push_back(vertex);
+            }
+        }
+        for (int corner = 0; corner < 3; corner++) {
+            // Move the emitted triangle past the end of the vertex's remaining range
+            const std::uint32_t vertex = triangle[corner];
+            const std::size_t first = adjacencyStart[vertex];
+            const std::size_t last = first + remaining[vertex] - 1;
+            for (std::size_t a = first; a <= last; a++) {
+                if (adjacency[a] == best) {
+                    std::swap(adjacency[a], adjacency[last]);
+                    break;
+                }
+            }
+            remaining[vertex]--;
+        }
+
+        // Rescore everything whose cache position changed, including vertices pushed out
+        for (std::size_t position = 0; position < newCache.size(); position++) {
+            const std::uint32_t vertex = newCache[position];
+            cachePosition[vertex] = position < static_cast<std::size_t>(CACHE_SIZE) ? static_cast<int>(position) : -1;
+            scores[vertex] = vertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+        if (newCache.size() > static_cast<std::size_t>(CACHE_SIZE)) {
+            newCache.resize(CACHE_SIZE);
+        }
+        cache.swap(newCache);
+
+        // The next triangle is the best scoring one among those using a cached vertex
+        float bestScore = -1.0f;
+        for (std::uint32_t vertex : cache) {
+            for (std::size_t a = adjacencyStart[vertex]; a < adjacencyStart[vertex] + remaining[vertex]; a++) {
+                const std::uint32_t t = adjacency[a];
+                triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                if (triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    best = t;
+                }
+            }
+        }
+        if (bestScore < 0.0f) {
+            // Nothing left touches the cache, continue with the next triangle in the original order
+            while (scanCursor < triangleCount && emitted[scanCursor]) {
+                scanCursor++;
+            }
+            best = scanCursor;
+        }
+    }
+    indices.swap(ordered);
+}
+
+void MeshBuilder::optimizeVertexFetch() {
+    const std::uint32_t UNUSED = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> remap(getVertexCount(), UNUSED);
+    std::vector<float> ordered;
+    ordered.reserve(vertices.size());
+    for (std::uint32_t &index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<std::uint32_t>(ordered.size() / floatsPerVertex);
+            ordered.insert(ordered.end(), vertices.begin() + index * floatsPerVertex, vertices.begin() + (index + 1) * floatsPerVertex);
+        }
+        index = remap[index];
+    }
+    // Vertices no triangle uses are dropped
+    vertices.swap(ordered);
+
+    // The weld table refers to the old numbering
+    weldTable.clear();
+    for (std::uint32_t v = 0; v < getVertexCount(); v++) {
+        weldTable.emplace(hashVertex(&vertices[v * floatsPerVertex]), v);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef OBMESHBUILDER_H
+#define OBMESHBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Turns triangle list vertices into an indexed mesh, welding identical vertices into one
+// optimize() then orders it for the GPU's post-transform vertex cache and for vertex fetch
+class MeshBuilder {
+    public:
+        // floatsPerVertex is the size of one interleaved vertex, e.g. 6 for a position and a normal
+        MeshBuilder(int floatsPerVertex);
+
+        // Append one triangle list vertex, every three make a triangle
+        // A vertex bitwise identical to an earlier one is only referenced again by index
+        void addVertex(const float* vertex);
+
+        // Append count triangle list vertices stored one after another
+        void addVertices(const float* vertices, std::size_t count);
+
+        // Reorder the triangles so vertices are reused while still in the vertex cache (Tom Forsyth's
+        // linear speed vertex cache optimisation), then renumber the vertices in the order the
+        // triangles first use them so fetching them walks through memory
+        void optimize();
+
+        // Interleaved vertex data, getVertexCount() * floatsPerVertex floats
+        const std::vector<float> &getVertices() const;
+
+        // Three indices per triangle
+        const std::vector<std::uint32_t> &getIndices() const;
+
+        std::size_t getVertexCount() const;
+        int getFloatsPerVertex() const;
+
+        // Average cache miss ratio, the vertices a FIFO cache of cacheSize entries would transform per triangle
+        // 3 means no reuse at all, the lower bound is the vertex count over the triangle count
+        float getACMR(int cacheSize = 16) const;
+
+    private:
+        const int floatsPerVertex;
+        std::vector<float> vertices;
+        std::vector<std::uint32_t> indices;
+
+        // Vertex hashes to the indices of the vertices with that hash
+        std::unordered_multimap<std::size_t, std::uint32_t> weldTable;
+
+        std::size_t hashVertex(const float* vertex) const;
+
+        // Forsyth's triangle reordering, replaces indices
+        void optimizeVertexCache();
+
+        // Renumber vertices by first use, replaces vertices and indices
+        void optimizeVertexFetch();
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "obRenderQueue.h"
+
+#include <utility>
+
+namespace {
+    const int DIGIT_BITS = 8;
+    const int DIGIT_COUNT = 64 / DIGIT_BITS;
+    const int BUCKET_COUNT = 1 << DIGIT_BITS;
+
+    // Below this many draws clearing and walking the histograms costs more than it saves
+    const std::size_t INSERTION_SORT_LIMIT = 64;
+
+    constexpr std::uint64_t fieldMask(unsigned int bits) {
+        return (std::uint64_t(1) << bits) - 1;
+    }
+
+    // Where each field starts, counted from the least significant bit
+    const unsigned int TRANSLUCENT_SHIFT = 64 - RenderQueue::PASS_BITS - 1;
+    const unsigned int PASS_SHIFT = TRANSLUCENT_SHIFT + 1;
+
+    // Opaque keys
+    const unsigned int OPAQUE_DEPTH_SHIFT = 0;
+    const unsigned int OPAQUE_MESH_SHIFT = OPAQUE_DEPTH_SHIFT + RenderQueue::DEPTH_BITS;
+    const unsigned int OPAQUE_MATERIAL_SHIFT = OPAQUE_MESH_SHIFT + RenderQueue::MESH_BITS;
+    const unsigned int OPAQUE_SHADER_SHIFT = OPAQUE_MATERIAL_SHIFT + RenderQueue::MATERIAL_BITS;
+
+    // Translucent keys
+    const unsigned int TRANSLUCENT_MESH_SHIFT = 0;
+    const unsigned int TRANSLUCENT_MATERIAL_SHIFT = TRANSLUCENT_MESH_SHIFT + RenderQueue::MESH_BITS;
+    const unsigned int TRANSLUCENT_SHADER_SHIFT = TRANSLUCENT_MATERIAL_SHIFT + RenderQueue::MATERIAL_BITS;
+    const unsigned int TRANSLUCENT_DEPTH_SHIFT = TRANSLUCENT_SHADER_SHIFT + RenderQueue::SHADER_BITS;
+
+    static_assert(OPAQUE_SHADER_SHIFT + RenderQueue::SHADER_BITS == TRANSLUCENT_SHIFT, "opaque key fields must fill 64 bits");
+    static_assert(TRANSLUCENT_DEPTH_SHIFT + RenderQueue::DEPTH_BITS == TRANSLUCENT_SHIFT, "translucent key fields must fill 64 bits");
+
+    std::uint64_t quantizeDepth(float depth) {
+        // Written so NaN ends up at 0 as well
+        if (!(depth > 0.0f)) {
+            return 0;
+        }
+        if (depth >= 1.0f) {
+            return fieldMask(RenderQueue::DEPTH_BITS);
+        }
+        return static_cast<std::uint64_t>(depth * static_cast<float>(fieldMask(RenderQueue::DEPTH_BITS)));
+    }
+
+    unsigned int getField(std::uint64_t key, unsigned int shift, unsigned int bits) {
+        return static_cast<unsigned int>((key >> shift) & fieldMask(bits));
+    }
+}
+
+std::uint64_t RenderQueue::makeKey(unsigned int pass, bool translucent, unsigned int shader,
+                                   unsigned int material, unsigned int mesh, float depth) {
+    std::uint64_t key = (pass & fieldMask(PASS_BITS)) << PASS_SHIFT;
+    const std::uint64_t quantized = quantizeDepth(depth);
+    if (translucent) {
+        key |= std::uint64_t(1) << TRANSLUCENT_SHIFT;
+        // Farthest first
+        key |= (fieldMask(DEPTH_BITS) - quantized) << TRANSLUCENT_DEPTH_SHIFT;
+        key |= (shader & fieldMask(SHADER_BITS)) << TRANSLUCENT_SHADER_SHIFT;
+        key |= (material & fieldMask(MATERIAL_BITS)) << TRANSLUCENT_MATERIAL_SHIFT;
+        key |= (mesh & fieldMask(MESH_BITS)) << TRANSLUCENT_MESH_SHIFT;
+    } else {
+        key |= (shader & fieldMask(SHADER_BITS)) << OPAQUE_SHADER_SHIFT;
+        key |= (material & fieldMask(MATERIAL_BITS)) << OPAQUE_MATERIAL_SHIFT;
+        key |= (mesh & fieldMask(MESH_BITS)) << OPAQUE_MESH_SHIFT;
+        // Nearest first, so early depth testing rejects what's hidden behind it
+        key |= quantized << OPAQUE_DEPTH_SHIFT;
+    }
+    return key;
+}
+
+unsigned int RenderQueue::getPass(std::uint64_t key) {
+    return getField(key, PASS_SHIFT, PASS_BITS);
+}
+
+bool RenderQueue::isTranslucent(std::uint64_t key) {
+    return getField(key, TRANSLUCENT_SHIFT, 1) != 0;
+}
+
+unsigned int RenderQueue::getShader(std::uint64_t key) {
+    return isTranslucent(key) ? getField(key, TRANSLUCENT_SHADER_SHIFT, SHADER_BITS) : getField(key, OPAQUE_SHADER_SHIFT, SHADER_BITS);
+}
+
+unsigned int RenderQueue::getMaterial(std::uint64_t key) {
+    return isTranslucent(key) ? getField(key, TRANSLUCENT_MATERIAL_SHIFT, MATERIAL_BITS) : getField(key, OPAQUE_MATERIAL_SHIFT, MATERIAL_BITS);
+}
+
+unsigned int RenderQueue::getMesh(std::uint64_t key) {
+    return isTranslucent(key) ? getField(key, TRANSLUCENT_MESH_SHIFT, MESH_BITS) : getField(key, OPAQUE_MESH_SHIFT, MESH_BITS);
+}
+
+void RenderQueue::push(std::uint64_t key, std::uint32_t payload) {
+    items.push_back({key, payload});
+}
+
+void RenderQueue::sort() {
+    const std::size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+
+    // Insertion sort only moves an item past greater keys, so it is stable as well
+    if (count <= INSERTION_SORT_LIMIT) {
+        for (std::size_t i = 1; i < count; i++) {
+            const Item item = items[i];
+            std::size_t j = i;
+            while (j > 0 && items[j - 1].key > item.key) {
+                items[j] = items[j - 1];
+                j--;
+            }
+            items[j] = item;
+        }
+        return;
+    }
+
+    // Histogram every digit in one pass over the keys
+    std::uint32_t histograms[DIGIT_COUNT][BUCKET_COUNT] = {};
+    for (const Item &item : items) {
+        for (int digit = 0; digit < DIGIT_COUNT; digit++) {
+            histograms[digit][(item.key >> (digit * DIGIT_BITS)) & (BUCKET_COUNT - 1)]++;
+        }
+    }
+
+    scratch.resize(count);
+    for (int digit = 0; digit < DIGIT_COUNT; digit++) {
+        std::uint32_t* histogram = histograms[digit];
+        const int shift = digit * DIGIT_BITS;
+
+        // Every key has the same digit here (an unused ID field, all draws in one pass), nothing would move
+        if (histogram[(items[0].key >> shift) & (BUCKET_COUNT - 1)] == count) {
+            continue;
+        }
+
+        // Turn the counts into each bucket's first slot
+        std::uint32_t offset = 0;
+        for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+            const std::uint32_t bucketSize = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketSize;
+        }
+
+        // Scatter in order, which keeps each pass stable
+        for (const Item &item : items) {
+            scratch[histogram[(item.key >> shift) & (BUCKET_COUNT - 1)]++] = item;
+        }
+        std::swap(items, scratch);
+    }
+}
+
+const std::vector<RenderQueue::Item> &RenderQueue::getItems() const {
+    return items;
+}
+
+std::size_t RenderQueue::size() const {
+    return items.size();
+}
+
+void RenderQueue::clear() {
+    items.clear();
+}
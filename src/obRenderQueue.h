@@ -0,0 +1,63 @@
+#ifndef OBRENDERQUEUE_H
+#define OBRENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Collects a frame's draws, each with a 64 bit sort key, and sorts them before they are issued
+// so draws sharing a program, material and mesh end up next to each other
+// The queue doesn't draw anything itself: every entry carries a payload, e.g. an index into the
+// caller's own table of draws, and the caller walks getItems() after sort()
+//
+// Key layout, most significant bits first
+//   opaque:      pass (4) | 0 | shader (11) | material (12) | mesh (12) | depth (24), front to back
+//   translucent: pass (4) | 1 | depth (24), back to front | shader (11) | material (12) | mesh (12)
+// Translucent draws have to blend in depth order, so for them depth outranks state
+class RenderQueue {
+    public:
+        static constexpr unsigned int PASS_BITS = 4;
+        static constexpr unsigned int SHADER_BITS = 11;
+        static constexpr unsigned int MATERIAL_BITS = 12;
+        static constexpr unsigned int MESH_BITS = 12;
+        static constexpr unsigned int DEPTH_BITS = 24;
+
+        struct Item {
+            std::uint64_t key;
+            std::uint32_t payload;
+        };
+
+        // Pack a key, IDs wider than their field are masked
+        // depth is normalized, 0 at the camera and 1 at the far plane, and clamped to that range
+        static std::uint64_t makeKey(unsigned int pass, bool translucent, unsigned int shader,
+                                     unsigned int material, unsigned int mesh, float depth);
+
+        // Unpack the fields of a key, e.g. to tell when the program needs to change
+        static unsigned int getPass(std::uint64_t key);
+        static bool isTranslucent(std::uint64_t key);
+        static unsigned int getShader(std::uint64_t key);
+        static unsigned int getMaterial(std::uint64_t key);
+        static unsigned int getMesh(std::uint64_t key);
+
+        // Queue a draw for this frame
+        void push(std::uint64_t key, std::uint32_t payload);
+
+        // Order the queued draws by key, draws with equal keys keep the order they were pushed in
+        // An LSD radix sort over 8 bit digits, digits every key shares are skipped
+        // and a handful of draws just gets an insertion sort
+        void sort();
+
+        const std::vector<Item> &getItems() const;
+        std::size_t size() const;
+
+        // Empty the queue for the next frame, keeps the memory
+        void clear();
+
+    private:
+        std::vector<Item> items;
+
+        // Where sort() scatters each pass before swapping it with items
+        std::vector<Item> scratch;
+};
+
+#endif
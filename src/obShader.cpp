@@ -1,106 +1,141 @@
 #include "obShader.h"
+#include "obGLState.h"
 
-#include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-std::string loadShaders(const std::string filename) {
-    std::ifstream file;
-    file.exceptions(file.exceptions() | std::ios::failbit | std::ios::badbit);
-    try {
-        file.open(filename.c_str());
-    } catch (std::exception e) {
-        std::cerr << "ERROR::SHADER::FILE_READ_FAILURE -->" << filename  << " -> " << e.what() << std::endl;
-        return "";
+
+Shader::Shader(const std::string vertexPath, const std::string fragmentPath, COMPILE_MODE mode, const std::vector<std::string> defines)
+    : vertex(&getShaderStage(GL_VERTEX_SHADER, vertexPath, defines, mode)),
+      fragment(&getShaderStage(GL_FRAGMENT_SHADER, fragmentPath, defines, mode)) {
+    uniformTargets.resize(1);
+    isReady();
+}
+
+Shader::~Shader() {
+    if (ID != 0) {
+        GLState::deleteProgramPipelines(1, &ID);
     }
+}
 
-    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-    return text;
+bool Shader::dependsOn(const std::string &path) const {
+    return vertex->dependsOn(path) || fragment->dependsOn(path);
 }
 
-Shader::Shader(const std::string vertexPath, const std::string fragmentPath) {
-    // See LearnOpenGL's section on shaders: https://learnopengl.com/Getting-started/Shaders
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+void Shader::reload() {
+    vertex->reload();
+    fragment->reload();
+}
 
-    // Load Shaders
-    const std::filesystem::path shaderSourceDir = SHADER_PATH;
-    std::string vertexShaderString = loadShaders(shaderSourceDir.string() + vertexPath);
-    std::string fragmentShaderString = loadShaders(shaderSourceDir.string() + fragmentPath);
-    if (vertexShaderString == "" || fragmentShaderString == "") {
-        std::cerr << "ERROR::SHADER::FAILED_SHADER_LOAD" << std::endl;
+bool Shader::isReady() {
+    // Poll both, so neither stage waits on the other to be noticed
+    const bool vertexReady = vertex->isReady();
+    const bool fragmentReady = fragment->isReady();
+    if (vertexReady && fragmentReady &&
+        (vertex->getGeneration() != vertexGeneration || fragment->getGeneration() != fragmentGeneration)) {
+        attachStages();
     }
-    const char* vertexShaderSource = vertexShaderString.c_str();
-    const char* fragmentShaderSource = fragmentShaderString.c_str();
-
-    // Compile vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertex);
-
-    // Check if vertex shader compilation was successful
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+    return ready;
+}
+
+void Shader::attachStages() {
+    // Pipelines are container objects, so this is only ever called on the main thread's context
+    if (ID == 0) {
+        glGenProgramPipelines(1, &ID);
     }
+    glUseProgramStages(ID, GL_VERTEX_SHADER_BIT, vertex->ID);
+    glUseProgramStages(ID, GL_FRAGMENT_SHADER_BIT, fragment->ID);
+    vertexGeneration = vertex->getGeneration();
+    fragmentGeneration = fragment->getGeneration();
 
-    // Compile fragment shader
-    fragment= glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragment);
+    // Separately linked stages are only matched up here, report interfaces that don't line up
+    int valid = 0;
+    glValidateProgramPipeline(ID);
+    glGetProgramPipelineiv(ID, GL_VALIDATE_STATUS, &valid);
+    if (!valid) {
+        char infoLog[512];
+        glGetProgramPipelineInfoLog(ID, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PIPELINE::VALIDATION_FAILED\n" << infoLog << std::endl;
+    }
+    ready = true;
 
-    // Check if fragment shader compilation was successful
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    for (std::function<void(Shader &)> &callback : readyCallbacks) {
+        callback(*this);
     }
+}
 
-    // Shader program setup
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-
-    // Check for shader program success
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINK_FAILED\n" << infoLog << std::endl;
+void Shader::onReady(std::function<void(Shader &)> callback) {
+    readyCallbacks.push_back(std::move(callback));
+    if (ready) {
+        readyCallbacks.back()(*this);
     }
+}
+
+Shader::UploadStats Shader::getUploadStats() {
+    return ShaderStage::getUploadStats();
+}
 
-    // Delete the now unneeded (after linking) shader objects
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+void Shader::resetUploadStats() {
+    ShaderStage::resetUploadStats();
 }
 
 void Shader::use() {
-    glUseProgram(ID);
+    GLState::bindProgramPipeline(ID);
+}
+
+UniformHandle Shader::getUniform(const std::string &name) const {
+    auto slot = uniformSlots.emplace(name, static_cast<int>(uniformTargets.size()));
+    if (slot.second) {
+        uniformTargets.push_back({vertex->getUniform(name), fragment->getUniform(name)});
+    }
+    return UniformHandle{slot.first->second};
 }
 
 void Shader::setBool(const std::string &name, bool value) const
-{         
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+{
+    setBool(getUniform(name), value);
 }
 void Shader::setInt(const std::string &name, int value) const
-{ 
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+{
+    setInt(getUniform(name), value);
 }
 void Shader::setFloat(const std::string &name, float value) const
-{ 
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
-} 
+{
+    setFloat(getUniform(name), value);
+}
 void Shader::setMat4(const std::string &name, glm::mat4 value) const
-{ 
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
-} 
+{
+    setMat4(getUniform(name), value);
+}
 void Shader::setVec3(const std::string &name, glm::vec3 value) const
-{ 
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
-} 
\ No newline at end of file
+{
+    setVec3(getUniform(name), value);
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const
+{
+    setInt(handle, (int)value);
+}
+void Shader::setInt(UniformHandle handle, int value) const
+{
+    const UniformSlot &slot = uniformTargets[handle.index];
+    vertex->setInt(slot.vertex, value);
+    fragment->setInt(slot.fragment, value);
+}
+void Shader::setFloat(UniformHandle handle, float value) const
+{
+    const UniformSlot &slot = uniformTargets[handle.index];
+    vertex->setFloat(slot.vertex, value);
+    fragment->setFloat(slot.fragment, value);
+}
+void Shader::setMat4(UniformHandle handle, const glm::mat4 &value) const
+{
+    const UniformSlot &slot = uniformTargets[handle.index];
+    vertex->setMat4(slot.vertex, value);
+    fragment->setMat4(slot.fragment, value);
+}
+void Shader::setVec3(UniformHandle handle, const glm::vec3 &value) const
+{
+    const UniformSlot &slot = uniformTargets[handle.index];
+    vertex->setVec3(slot.vertex, value);
+    fragment->setVec3(slot.fragment, value);
+}
@@ -1,29 +1,102 @@
 #ifndef OBSHADER_H
 #define OBSHADER_H
 
+#include "obShaderStage.h"
+
 #include <glad/glad.h>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 
-
+// A vertex and a fragment stage combined in a program pipeline
+// The stages are separable programs shared with every other Shader built from the same file and defines
 class Shader {
     public:
-        // The shader program's ID
-        unsigned int ID;
+        using COMPILE_MODE = ShaderStage::COMPILE_MODE;
+        static constexpr COMPILE_MODE IMMEDIATE = ShaderStage::IMMEDIATE; // Compile and link before the constructor returns
+        static constexpr COMPILE_MODE DEFERRED = ShaderStage::DEFERRED;   // Submit the compile and return, poll isReady() before using the shader
+
+        // The program pipeline's ID, 0 until both stages have linked
+        unsigned int ID = 0;
 
         // A constructor that will read the shader and compile it
         // Give shader paths relative to the /shaders directory
-        Shader(const std::string vertexPath, const std::string fragmentPath);
+        // defines ("NAME" or "NAME VALUE") are injected into whichever stages use them
+        Shader(const std::string vertexPath, const std::string fragmentPath, COMPILE_MODE mode = IMMEDIATE, const std::vector<std::string> defines = {});
+        ~Shader();
+
+        Shader(const Shader &) = delete;
+        Shader &operator=(const Shader &) = delete;
 
         // Use and activate the shader
         void use();
 
+        // Whether both stages are linked, finishes deferred builds once the driver is done
+        // Call this from the main thread, e.g. once per frame before choosing what to draw with
+        bool isReady();
+
+        // Run callback every time a newly linked stage becomes active (immediately if the shader is ready)
+        // This is the place to resolve uniform handles and set constant uniforms
+        void onReady(std::function<void(Shader &)> callback);
+
+        // Whether either stage is built from the given file (relative to the /shaders directory), includes count too
+        bool dependsOn(const std::string &path) const;
+
+        // Recompile both stages from the current sources in the background, other shaders sharing them pick it up too
+        // A stage's new program replaces the old one only once it has linked, a failed build keeps the old one
+        void reload();
+
+        // Resolve a uniform name into a handle for the handle based setters
+        // Names neither stage has yet still get a handle, it takes effect if a reload adds the uniform
+        UniformHandle getUniform(const std::string &name) const;
+
         // Utilities for uniforms
         void setBool(const std::string &name, bool value) const;
         void setInt(const std::string &name, int value) const;
         void setFloat(const std::string &name, float value) const;
         void setMat4(const std::string &name, glm::mat4 value) const;
         void setVec3(const std::string &name, glm::vec3 value) const;
+
+        // Utilities for pre-resolved uniforms, these only index the location tables
+        // Values are shadowed per stage, setting a uniform to the value it already has issues no GL call
+        void setBool(UniformHandle handle, bool value) const;
+        void setInt(UniformHandle handle, int value) const;
+        void setFloat(UniformHandle handle, float value) const;
+        void setMat4(UniformHandle handle, const glm::mat4 &value) const;
+        void setVec3(UniformHandle handle, const glm::vec3 &value) const;
+
+        // Uniform uploads sent to GL and skipped as unchanged, summed over every shader
+        using UploadStats = ShaderStage::UploadStats;
+
+        // Counts since the last reset, e.g. reset at the start of each frame to get per-frame numbers
+        static UploadStats getUploadStats();
+        static void resetUploadStats();
+
+    private:
+        ShaderStage* vertex;
+        ShaderStage* fragment;
+
+        // Generations of the stage programs currently attached to the pipeline
+        unsigned int vertexGeneration = 0;
+        unsigned int fragmentGeneration = 0;
+
+        bool ready = false;
+        std::vector<std::function<void(Shader &)>> readyCallbacks;
+
+        // Attach the stages' current programs to the pipeline
+        void attachStages();
+
+        // A uniform's slot in each stage, indexed by UniformHandle::index, slot 0 is always empty
+        struct UniformSlot {
+            UniformHandle vertex;
+            UniformHandle fragment;
+        };
+        mutable std::vector<UniformSlot> uniformTargets;
+
+        // Uniform names to their slot in uniformTargets
+        mutable std::unordered_map<std::string, int> uniformSlots;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "obShaderCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <system_error>
+#include <thread>
+
+namespace {
+    // Marks and versions the cache file layout
+    constexpr std::uint32_t CACHE_MAGIC = 0x4250424F; // "OBPB"
+    constexpr std::uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t format;
+        std::uint32_t length;
+    };
+
+    // 64-bit FNV-1a
+    constexpr std::uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+    constexpr std::uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    std::uint64_t hashBytes(std::uint64_t hash, const char* data, std::size_t length) {
+        for (std::size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    std::uint64_t hashString(std::uint64_t hash, const std::string &text) {
+        // Include the length so that ("ab", "c") and ("a", "bc") differ
+        std::uint64_t length = text.size();
+        hash = hashBytes(hash, reinterpret_cast<const char*>(&length), sizeof(length));
+        return hashBytes(hash, text.data(), text.size());
+    }
+
+    std::string glString(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+
+    // The driver can't give us binaries in any format
+    bool binariesSupported() {
+        static const bool supported = [] {
+            int formatCount = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+            return formatCount > 0;
+        }();
+        return supported;
+    }
+
+    std::filesystem::path cacheFile(std::uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return std::filesystem::path(SHADER_CACHE_PATH) / name;
+    }
+
+    // Suffix for a writer's temporary copy of an entry, different for every thread of every process
+    // so writers storing the same key never share a file
+    std::string temporarySuffix() {
+        thread_local std::random_device device;
+        std::uint64_t value = (static_cast<std::uint64_t>(device()) << 32) ^ device();
+        value ^= std::hash<std::thread::id>()(std::this_thread::get_id());
+        value ^= static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(value));
+        return suffix;
+    }
+}
+
+std::uint64_t programCacheKey(const std::vector<std::string> &sources) {
+    // The driver identity only needs to be read once per run
+    static const std::uint64_t driverHash = [] {
+        std::uint64_t hash = FNV_OFFSET;
+        hash = hashString(hash, glString(GL_VENDOR));
+        hash = hashString(hash, glString(GL_RENDERER));
+        hash = hashString(hash, glString(GL_VERSION));
+        return hash;
+    }();
+
+    std::uint64_t hash = driverHash;
+    for (const std::string &source : sources) {
+        hash = hashString(hash, source);
+    }
+    return hash;
+}
+
+bool loadProgramBinary(std::uint64_t key, GLuint program) {
+    if (!binariesSupported()) {
+        return false;
+    }
+
+    const std::filesystem::path path = cacheFile(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+        return false;
+    }
+
+    // A truncated or corrupt entry can claim any length, check it against the file before allocating
+    std::error_code error;
+    const std::uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error || fileSize < sizeof(header) || header.length > fileSize - sizeof(header)) {
+        file.close();
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+        return false;
+    }
+
+    // The driver is free to reject a binary (e.g. after an update), in which case the
+    // caller falls back to compiling from source and overwrites the stale entry
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+void storeProgramBinary(std::uint64_t key, GLuint program) {
+    if (!binariesSupported()) {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(SHADER_CACHE_PATH, error);
+    if (error) {
+        std::cerr << "ERROR::SHADER_CACHE::CREATE_DIRECTORY_FAILED --> " << SHADER_CACHE_PATH << " -> " << error.message() << std::endl;
+        return;
+    }
+
+    // Write to a temporary file of our own and rename it, so a concurrent run never reads half an entry
+    // and each rename publishes one writer's complete entry
+    const std::filesystem::path path = cacheFile(key);
+    std::filesystem::path temporary = path;
+    temporary += temporarySuffix();
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, format, static_cast<std::uint32_t>(length)};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            std::cerr << "ERROR::SHADER_CACHE::WRITE_FAILED --> " << temporary.string() << std::endl;
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cerr << "ERROR::SHADER_CACHE::WRITE_FAILED --> " << path.string() << " -> " << error.message() << std::endl;
+        std::filesystem::remove(temporary, error);
+    }
+}
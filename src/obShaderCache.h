@@ -0,0 +1,23 @@
+#ifndef OBSHADERCACHE_H
+#define OBSHADERCACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Persistent cache of linked program binaries, stored under SHADER_CACHE_PATH
+// Entries are keyed on the final shader sources and the driver that produced them,
+// so a driver update or a source edit simply misses the cache
+
+// Hash the given shader sources together with the current driver's vendor, renderer and version
+std::uint64_t programCacheKey(const std::vector<std::string> &sources);
+
+// Try to load a cached binary into program, returns true if the driver accepted and linked it
+bool loadProgramBinary(std::uint64_t key, GLuint program);
+
+// Save a successfully linked program's binary
+// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+void storeProgramBinary(std::uint64_t key, GLuint program);
+
+#endif
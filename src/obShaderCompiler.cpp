@@ -0,0 +1,107 @@
+#include "obShaderCompiler.h"
+
+#include <SFML/Window/Context.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace {
+    bool parallelCompile = false;
+
+    // The shared context worker, started on the first submitted job
+    std::thread worker;
+    std::mutex queueMutex;
+    std::condition_variable queueSignal;
+    std::deque<std::function<void()>> queue;
+    bool stopping = false;
+
+    // Replaces the worker's sf::Context when set
+    std::function<std::function<void()>()> acquireWorkerContext;
+
+    void workerLoop() {
+        // SFML contexts share their objects with every other context, including the window's
+        std::optional<sf::Context> context;
+        std::function<void()> releaseContext;
+        if (acquireWorkerContext) {
+            releaseContext = acquireWorkerContext();
+        } else {
+            context.emplace();
+        }
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueSignal.wait(lock, [] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    break;
+                }
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+        if (releaseContext) {
+            releaseContext();
+        }
+    }
+}
+
+void initShaderCompiler(GLADloadproc loader) {
+    int extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    const char* threadsFunction = nullptr;
+    for (int i = 0; i < extensionCount; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0) {
+            threadsFunction = "glMaxShaderCompilerThreadsKHR";
+        } else if (std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0 && threadsFunction == nullptr) {
+            threadsFunction = "glMaxShaderCompilerThreadsARB";
+        }
+    }
+    parallelCompile = threadsFunction != nullptr;
+
+    // Let the driver pick as many compiler threads as it wants
+    if (parallelCompile) {
+        typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+        auto maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(loader(threadsFunction));
+        if (maxShaderCompilerThreads) {
+            maxShaderCompilerThreads(0xFFFFFFFF);
+        }
+    }
+}
+
+void setShaderWorkerContext(std::function<std::function<void()>()> acquire) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    acquireWorkerContext = std::move(acquire);
+}
+
+bool parallelShaderCompileSupported() {
+    return parallelCompile;
+}
+
+void runOnShaderWorker(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(job));
+        if (!worker.joinable()) {
+            stopping = false;
+            worker = std::thread(workerLoop);
+        }
+    }
+    queueSignal.notify_one();
+}
+
+void shutdownShaderCompiler() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueSignal.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef OBSHADERCOMPILER_H
+#define OBSHADERCOMPILER_H
+
+#include <glad/glad.h>
+#include <functional>
+
+// Backends for compiling shader programs off the main thread's critical path
+// With GL_KHR_parallel_shader_compile the driver compiles in the background and we only poll,
+// otherwise compilation is handed to a worker thread that owns a context shared with the window's
+
+// Not part of the 4.1 core headers, see GL_KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Detect parallel compile support and let the driver use all of its compiler threads
+// Call once with the main context current, after the GL loader has been initialized
+void initShaderCompiler(GLADloadproc loader);
+
+// Whether the driver compiles in the background and can be polled with GL_COMPLETION_STATUS_KHR
+bool parallelShaderCompileSupported();
+
+// Queue a job on the shared context worker, jobs run in submission order
+// Other contexts may only use what the job creates once the worker's context has finished it,
+// so the job has to glFinish() before it signals that its results are ready
+void runOnShaderWorker(std::function<void()> job);
+
+// How the worker gets its context when there is no window to share with (see HeadlessContext)
+// The function runs on the worker thread before its first job, makes a context sharing objects with the main one
+// current and returns what releases it again, by default the worker uses an sf::Context
+// Call before the first job is queued
+void setShaderWorkerContext(std::function<std::function<void()>()> acquire);
+
+// Finish queued jobs and release the worker's context, call before the window closes
+void shutdownShaderCompiler();
+
+#endif
@@ -0,0 +1,32 @@
+#include "obShaderPermutations.h"
+#include "obShaderWatcher.h"
+
+ShaderPermutations::ShaderPermutations(const std::string vertexPath, const std::string fragmentPath,
+                                       const std::vector<std::string> featureDefines, const std::string countDefine,
+                                       Shader::COMPILE_MODE mode, ShaderWatcher* watcher)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), featureDefines(featureDefines),
+      countDefine(countDefine), mode(mode), watcher(watcher) {}
+
+Shader &ShaderPermutations::get(std::uint32_t key) {
+    auto variant = variants.find(key);
+    if (variant != variants.end()) {
+        return *variant->second;
+    }
+
+    std::vector<std::string> defines;
+    for (std::size_t bit = 0; bit < featureDefines.size() && bit < 16; bit++) {
+        if (key & (1u << bit)) {
+            defines.push_back(featureDefines[bit]);
+        }
+    }
+    // A count of 0 leaves the define out, so the shader's own default applies rather than e.g. a zero length array
+    if (!countDefine.empty() && (key >> 16) != 0) {
+        defines.push_back(countDefine + " " + std::to_string(key >> 16));
+    }
+
+    std::unique_ptr<Shader> shader = std::make_unique<Shader>(vertexPath, fragmentPath, mode, defines);
+    if (watcher) {
+        watcher->watch(*shader);
+    }
+    return *variants.emplace(key, std::move(shader)).first->second;
+}
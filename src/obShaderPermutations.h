@@ -0,0 +1,49 @@
+#ifndef OBSHADERPERMUTATIONS_H
+#define OBSHADERPERMUTATIONS_H
+
+#include "obShader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ShaderWatcher;
+
+// Specialized variants of one vertex + fragment pair, compiled on first use and cached by key
+// A key's low 16 bits switch features on (bit i injects "#define featureDefines[i]") and
+// its high 16 bits hold a count that is injected as "#define countDefine <count>"
+// A count of 0 isn't injected, the shader should then fall back to its own default (e.g. #ifndef NUM_LIGHTS)
+class ShaderPermutations {
+    public:
+        // Give shader paths relative to the /shaders directory
+        // Variants are compiled with mode and, if a watcher is given, hot-reloaded by it
+        ShaderPermutations(const std::string vertexPath, const std::string fragmentPath,
+                           const std::vector<std::string> featureDefines, const std::string countDefine = "",
+                           Shader::COMPILE_MODE mode = Shader::DEFERRED, ShaderWatcher* watcher = nullptr);
+
+        ShaderPermutations(const ShaderPermutations &) = delete;
+        ShaderPermutations &operator=(const ShaderPermutations &) = delete;
+
+        // Build a key from a feature bitmask and a count
+        static std::uint32_t makeKey(std::uint32_t features, std::uint32_t count = 0) {
+            return (features & 0xFFFFu) | (count << 16);
+        }
+
+        // The variant for key, submitted for compilation the first time it is asked for
+        // The reference stays valid for the lifetime of this object
+        Shader &get(std::uint32_t key);
+
+    private:
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::vector<std::string> featureDefines;
+        std::string countDefine;
+        Shader::COMPILE_MODE mode;
+        ShaderWatcher* watcher;
+
+        std::unordered_map<std::uint32_t, std::unique_ptr<Shader>> variants;
+};
+
+#endif
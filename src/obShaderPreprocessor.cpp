@@ -0,0 +1,92 @@
+#include "obShaderPreprocessor.h"
+#include "obShaderSource.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace {
+    // Guards against runaway nesting, repeated includes are already skipped
+    constexpr int MAX_INCLUDE_DEPTH = 16;
+
+    // Append path's text to output with its includes expanded in place
+    bool expandFile(const std::string &path, std::vector<std::string> &files, std::string &output, int depth) {
+        std::string text = readShaderSource(path);
+        if (text == "") {
+            return false;
+        }
+
+        const int fileIndex = static_cast<int>(files.size());
+        files.push_back(path);
+
+        std::istringstream lines(text);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(lines, line)) {
+            lineNumber++;
+
+            std::string::size_type start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+                output += line;
+                output += '\n';
+                continue;
+            }
+
+            std::string::size_type open = line.find('"', start);
+            std::string::size_type close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos) {
+                std::cerr << "ERROR::SHADER::PREPROCESSOR::BAD_INCLUDE --> " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            const std::string includePath = "/" + line.substr(open + 1, close - open - 1);
+
+            bool alreadyIncluded = false;
+            for (const std::string &file : files) {
+                alreadyIncluded = alreadyIncluded || file == includePath;
+            }
+            if (!alreadyIncluded) {
+                if (depth >= MAX_INCLUDE_DEPTH) {
+                    std::cerr << "ERROR::SHADER::PREPROCESSOR::INCLUDE_TOO_DEEP --> " << path << ":" << lineNumber << std::endl;
+                    return false;
+                }
+                output += "#line 1 " + std::to_string(files.size()) + "\n";
+                if (!expandFile(includePath, files, output, depth + 1)) {
+                    std::cerr << "ERROR::SHADER::PREPROCESSOR::INCLUDE_FAILED --> " << path << ":" << lineNumber << std::endl;
+                    return false;
+                }
+            }
+
+            // Carry on numbering from the line after the include
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+        }
+        return true;
+    }
+}
+
+std::string preprocessShader(const std::string &path, const std::vector<std::string> &defines, std::vector<std::string> &files) {
+    files.clear();
+    std::string body;
+    if (!expandFile(path, files, body, 0)) {
+        return "";
+    }
+
+    // #version has to stay the first directive, so defines go right after it
+    std::string::size_type version = body.find("#version");
+    std::string::size_type insertAt = version == std::string::npos ? 0 : body.find('\n', version);
+    insertAt = insertAt == std::string::npos ? body.size() : insertAt + 1;
+
+    std::string injected;
+    for (const std::string &define : defines) {
+        injected += "#define " + define + "\n";
+    }
+    if (!injected.empty()) {
+        // Keep error line numbers pointing at the original file
+        int nextLine = 1;
+        for (std::string::size_type i = 0; i < insertAt; i++) {
+            nextLine += body[i] == '\n';
+        }
+        injected += "#line " + std::to_string(nextLine) + " 0\n";
+    }
+
+    body.insert(insertAt, injected);
+    return body;
+}
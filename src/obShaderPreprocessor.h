@@ -0,0 +1,14 @@
+#ifndef OBSHADERPREPROCESSOR_H
+#define OBSHADERPREPROCESSOR_H
+
+#include <string>
+#include <vector>
+
+// Load a shader (path relative to the /shaders directory) and expand its #include "file.glsl" directives
+// Each file is included at most once, includes are resolved relative to the /shaders directory
+// defines are injected right after the #version line, either "NAME" or "NAME VALUE"
+// files receives every file read, its index is the GLSL source string number used in #line and error logs
+// Returns an empty string if the shader or one of its includes can't be read
+std::string preprocessShader(const std::string &path, const std::vector<std::string> &defines, std::vector<std::string> &files);
+
+#endif
@@ -0,0 +1,65 @@
+#include "obShaderSource.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#ifdef OBELISK_EMBED_SHADERS
+#include "obEmbeddedShaders.h"
+#endif
+
+std::string loadShaders(const std::string filename) {
+    std::ifstream file;
+    file.exceptions(file.exceptions() | std::ios::failbit | std::ios::badbit);
+    try {
+        file.open(filename.c_str());
+    } catch (std::exception e) {
+        std::cerr << "ERROR::SHADER::FILE_READ_FAILURE -->" << filename  << " -> " << e.what() << std::endl;
+        return "";
+    }
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    return text;
+}
+
+namespace {
+    // The development override, empty if it isn't set
+    const std::string &overrideDirectory() {
+        static const std::string directory = [] {
+            const char* value = std::getenv("OBELISK_SHADER_PATH");
+            return std::string(value ? value : "");
+        }();
+        return directory;
+    }
+}
+
+bool shadersFromDisk() {
+#ifdef OBELISK_EMBED_SHADERS
+    return !overrideDirectory().empty();
+#else
+    return true;
+#endif
+}
+
+std::string shaderDirectory() {
+    if (!overrideDirectory().empty()) {
+        return overrideDirectory();
+    }
+    return SHADER_PATH;
+}
+
+std::string readShaderSource(const std::string &path) {
+#ifdef OBELISK_EMBED_SHADERS
+    if (!shadersFromDisk()) {
+        for (const EmbeddedShader &shader : EMBEDDED_SHADERS) {
+            if (shader.name == path) {
+                return std::string(shader.source);
+            }
+        }
+        std::cerr << "ERROR::SHADER::NOT_EMBEDDED --> " << path << std::endl;
+        return "";
+    }
+#endif
+    return loadShaders(shaderDirectory() + path);
+}
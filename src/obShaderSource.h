@@ -0,0 +1,24 @@
+#ifndef OBSHADERSOURCE_H
+#define OBSHADERSOURCE_H
+
+#include <string>
+
+// Where shader sources come from
+// Builds with OBELISK_EMBED_SHADERS carry every file of /shaders inside the executable and do no file I/O,
+// others read from SHADER_PATH. Setting the OBELISK_SHADER_PATH environment variable reads from that
+// directory instead in either kind of build, e.g. to hot-reload shaders while developing a release build
+
+// Read a whole shader file, returns an empty string if it can't be read
+std::string loadShaders(const std::string filename);
+
+// Whether sources are read from disk (and so can be watched for changes)
+bool shadersFromDisk();
+
+// The directory sources are read from, only meaningful when shadersFromDisk()
+std::string shaderDirectory();
+
+// The source of a shader file given relative to the /shaders directory (e.g. "/basic.vert")
+// Returns an empty string if there is no such file
+std::string readShaderSource(const std::string &path);
+
+#endif
@@ -0,0 +1,443 @@
+#include "obShaderStage.h"
+#include "obShaderCache.h"
+#include "obShaderCompiler.h"
+#include "obShaderPreprocessor.h"
+#include "obUniformBlocks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <glm/gtc/type_ptr.hpp>
+
+ShaderStage::UploadStats ShaderStage::uploadStats;
+
+struct ShaderStage::Build {
+    GLenum type = 0;
+    std::string source;
+
+    // Files the stage was assembled from, indexed by GLSL source string number
+    std::vector<std::string> files;
+    std::uint64_t cacheKey = 0;
+
+    unsigned int program = 0;
+    unsigned int shader = 0;
+    bool fromCache = false;
+    bool linked = false;
+
+    // Polled through GL_COMPLETION_STATUS_KHR rather than completed by the worker
+    bool polled = false;
+
+    // Set once the build has finished, on whichever thread ran it
+    std::atomic<bool> done{false};
+};
+
+namespace {
+    // Map the source string numbers in a compile log back to file names
+    std::string describeSourceFiles(const std::vector<std::string> &files) {
+        std::string description;
+        for (std::size_t i = 0; i < files.size(); i++) {
+            description += std::to_string(i) + ": " + files[i] + "\n";
+        }
+        return description;
+    }
+
+    const char* stageName(GLenum type) {
+        return type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT";
+    }
+
+    bool isIdentifierChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    // Whether name appears in source as a whole identifier
+    bool mentionsName(const std::string &source, const std::string &name) {
+        for (std::size_t at = source.find(name); at != std::string::npos; at = source.find(name, at + 1)) {
+            const std::size_t end = at + name.size();
+            if ((at == 0 || !isIdentifierChar(source[at - 1])) && (end == source.size() || !isIdentifierChar(source[end]))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Every stage compiled so far, keyed by type, path and the defines that apply to it
+    std::unordered_map<std::string, std::unique_ptr<ShaderStage>> &stageCache() {
+        static std::unordered_map<std::string, std::unique_ptr<ShaderStage>> stages;
+        return stages;
+    }
+}
+
+ShaderStage::ShaderStage(GLenum type, const std::string path, COMPILE_MODE mode, const std::vector<std::string> defines) : type(type), path(path), defines(defines) {
+    uniformLocations.push_back(-1);
+    uniformShadows.resize(1);
+    submitBuild(mode);
+}
+
+void ShaderStage::submitBuild(COMPILE_MODE mode) {
+    // Load the shader, the defines end up in the source text and so in the cache key too
+    std::shared_ptr<Build> build = std::make_shared<Build>();
+    build->type = type;
+    build->source = preprocessShader(path, defines, build->files);
+    if (build->source == "") {
+        std::cerr << "ERROR::SHADER::FAILED_SHADER_LOAD --> " << path << std::endl;
+    }
+
+    // Watch everything that went into this build, including files that failed to load
+    dependencies = build->files;
+    dependencies.push_back(path);
+    build->cacheKey = programCacheKey({stageName(type), build->source});
+    pendingBuild = build;
+
+    if (mode == IMMEDIATE) {
+        startBuild(*build);
+        finishBuild(*build);
+        build->done = true;
+        completeBuild();
+    } else if (parallelShaderCompileSupported()) {
+        // The driver compiles on its own threads, isReady() polls for completion
+        build->polled = true;
+        startBuild(*build);
+    } else {
+        // The worker holds on to the build, so it is safe even if this stage goes away first
+        runOnShaderWorker([build] {
+            startBuild(*build);
+            finishBuild(*build);
+            // The main context may only use the program once the worker's context has finished creating it
+            glFinish();
+            build->done.store(true, std::memory_order_release);
+        });
+    }
+}
+
+bool ShaderStage::dependsOn(const std::string &path) const {
+    return std::find(dependencies.begin(), dependencies.end(), path) != dependencies.end();
+}
+
+void ShaderStage::reload() {
+    // Only one build is in flight at a time, the newest sources get picked up once it finishes
+    if (pendingBuild) {
+        reloadQueued = true;
+        return;
+    }
+    submitBuild(DEFERRED);
+}
+
+void ShaderStage::startBuild(Build &build) {
+    // A separable program may be combined with stages from other programs in a pipeline
+    // The flag has to be set before linking, or loading a binary
+    build.program = glCreateProgram();
+    glProgramParameteri(build.program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+    // Reuse a previously linked binary of this exact source when the driver accepts it
+    if (loadProgramBinary(build.cacheKey, build.program)) {
+        build.fromCache = true;
+        return;
+    }
+
+    // Compile and link, status is only checked once the link is done so
+    // that drivers with background compilation are never forced to wait here
+    const char* source = build.source.c_str();
+    build.shader = glCreateShader(build.type);
+    glShaderSource(build.shader, 1, &source, NULL);
+    glCompileShader(build.shader);
+
+    glAttachShader(build.program, build.shader);
+    glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(build.program);
+}
+
+void ShaderStage::finishBuild(Build &build) {
+    if (build.fromCache) {
+        build.linked = true;
+        return;
+    }
+
+    int success;
+    char infoLog[512];
+
+    // Check if compilation was successful
+    glGetShaderiv(build.shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(build.shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::" << stageName(build.type) << "::COMPILATION_FAILED\n" << describeSourceFiles(build.files) << infoLog << std::endl;
+    }
+
+    // Check for program success
+    glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(build.program, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINK_FAILED\n" << infoLog << std::endl;
+    } else {
+        storeProgramBinary(build.cacheKey, build.program);
+    }
+    build.linked = success != 0;
+
+    // Detach and delete the now unneeded (after linking) shader object
+    glDetachShader(build.program, build.shader);
+    glDeleteShader(build.shader);
+}
+
+bool ShaderStage::isReady() {
+    if (pendingBuild) {
+        Build &build = *pendingBuild;
+        if (build.polled && !build.done) {
+            int complete = 0;
+            glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+            if (complete) {
+                finishBuild(build);
+                build.done = true;
+            }
+        }
+        if (build.done.load(std::memory_order_acquire)) {
+            completeBuild();
+        }
+    }
+    return ready;
+}
+
+void ShaderStage::waitUntilReady() {
+    if (!pendingBuild) {
+        return;
+    }
+    Build &build = *pendingBuild;
+    if (build.polled) {
+        // Querying the results blocks until the driver is done
+        if (!build.done) {
+            finishBuild(build);
+            build.done = true;
+        }
+    } else {
+        while (!build.done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    completeBuild();
+}
+
+unsigned int ShaderStage::getGeneration() const {
+    return generation;
+}
+
+void ShaderStage::completeBuild() {
+    std::shared_ptr<Build> build = std::move(pendingBuild);
+    if (!build->linked) {
+        glDeleteProgram(build->program);
+        if (ready) {
+            std::cerr << "ERROR::SHADER::RELOAD_FAILED --> keeping the previous program of " << path << std::endl;
+        }
+    } else {
+        // Swap the new program in, GL defers deleting the old one while it is still in use
+        if (ready) {
+            glDeleteProgram(ID);
+        }
+        ID = build->program;
+        ready = true;
+        generation++;
+
+        // Resolve every uniform location once, instead of on every set call
+        introspectUniforms();
+        restoreUniforms();
+        bindUniformBlocks();
+    }
+
+    if (reloadQueued) {
+        reloadQueued = false;
+        reload();
+    }
+}
+
+void ShaderStage::introspectUniforms() {
+    // Slots survive reloads so handles resolved against an earlier program stay valid,
+    // uniforms that no longer exist just point back at location -1
+    std::fill(uniformLocations.begin(), uniformLocations.end(), -1);
+    auto assignSlot = [this](const std::string &name, GLint location) {
+        auto slot = uniformSlots.emplace(name, static_cast<int>(uniformLocations.size()));
+        if (slot.second) {
+            uniformLocations.push_back(location);
+        } else {
+            uniformLocations[slot.first->second] = location;
+        }
+    };
+
+    int uniformCount = 0;
+    int maxNameLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<char> nameBuffer(maxNameLength + 1);
+
+    for (int i = 0; i < uniformCount; i++) {
+        GLsizei nameLength = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, i, static_cast<GLsizei>(nameBuffer.size()), &nameLength, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), nameLength);
+
+        // Uniforms inside blocks have no location of their own
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location == -1) {
+            continue;
+        }
+
+        // Arrays are reported as "name[0]", register every element as well as the bare name
+        // (arrays of structs are already reported member by member)
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string baseName = name.substr(0, name.size() - 3);
+            // The bare name may have been resolved before any program showed it's an array,
+            // then element 0 takes over its slot rather than getting one of its own
+            auto bareSlot = uniformSlots.find(baseName);
+            if (bareSlot != uniformSlots.end()) {
+                uniformSlots.emplace(name, bareSlot->second);
+            }
+            for (int element = 0; element < size; element++) {
+                std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                assignSlot(elementName, glGetUniformLocation(ID, elementName.c_str()));
+            }
+            // The bare name shares element 0's slot, so both see the same shadowed value
+            // If both were resolved separately beforehand, the bare name's slot points at element 0 as well
+            if (!uniformSlots.emplace(baseName, uniformSlots[name]).second) {
+                assignSlot(baseName, location);
+            }
+        } else {
+            assignSlot(name, location);
+        }
+    }
+
+    uniformShadows.resize(uniformLocations.size());
+}
+
+void ShaderStage::restoreUniforms() {
+    // A new program starts with every uniform at zero, give it the values the old one had
+    for (std::size_t slot = 1; slot < uniformLocations.size(); slot++) {
+        const UniformShadow &shadow = uniformShadows[slot];
+        const GLint location = uniformLocations[slot];
+        if (location == -1 || shadow.type == 0) {
+            continue;
+        }
+        switch (shadow.type) {
+            case GL_INT:
+                glProgramUniform1iv(ID, location, 1, reinterpret_cast<const GLint*>(shadow.value));
+                break;
+            case GL_FLOAT:
+                glProgramUniform1fv(ID, location, 1, reinterpret_cast<const GLfloat*>(shadow.value));
+                break;
+            case GL_FLOAT_VEC3:
+                glProgramUniform3fv(ID, location, 1, reinterpret_cast<const GLfloat*>(shadow.value));
+                break;
+            case GL_FLOAT_MAT4:
+                glProgramUniformMatrix4fv(ID, location, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(shadow.value));
+                break;
+        }
+        uploadStats.issued++;
+    }
+}
+
+bool ShaderStage::updateShadow(UniformHandle handle, GLenum type, const void* value, std::size_t size) const {
+    // The empty slot never reaches GL
+    if (handle.index == 0) {
+        return false;
+    }
+
+    UniformShadow &shadow = uniformShadows[handle.index];
+    const bool unchanged = shadow.type == type && std::memcmp(shadow.value, value, size) == 0;
+    shadow.type = type;
+    std::memcpy(shadow.value, value, size);
+
+    // Keep the value for a later program that has the uniform, but don't count it against this one
+    if (uniformLocations[handle.index] == -1) {
+        return false;
+    }
+    if (unchanged) {
+        uploadStats.skipped++;
+        return false;
+    }
+    uploadStats.issued++;
+    return true;
+}
+
+ShaderStage::UploadStats ShaderStage::getUploadStats() {
+    return uploadStats;
+}
+
+void ShaderStage::resetUploadStats() {
+    uploadStats = UploadStats();
+}
+
+void ShaderStage::bindUniformBlocks() {
+    for (const UniformBlockBinding &block : UNIFORM_BLOCK_BINDINGS) {
+        GLuint blockIndex = glGetUniformBlockIndex(ID, block.name);
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(ID, blockIndex, block.binding);
+        }
+    }
+}
+
+UniformHandle ShaderStage::getUniform(const std::string &name) {
+    auto slot = uniformSlots.emplace(name, static_cast<int>(uniformLocations.size()));
+    if (slot.second) {
+        uniformLocations.push_back(-1);
+        uniformShadows.resize(uniformLocations.size());
+    }
+    return UniformHandle{slot.first->second};
+}
+
+void ShaderStage::setInt(UniformHandle handle, int value) const
+{
+    if (updateShadow(handle, GL_INT, &value, sizeof(value))) {
+        glProgramUniform1i(ID, uniformLocations[handle.index], value);
+    }
+}
+void ShaderStage::setFloat(UniformHandle handle, float value) const
+{
+    if (updateShadow(handle, GL_FLOAT, &value, sizeof(value))) {
+        glProgramUniform1f(ID, uniformLocations[handle.index], value);
+    }
+}
+void ShaderStage::setMat4(UniformHandle handle, const glm::mat4 &value) const
+{
+    if (updateShadow(handle, GL_FLOAT_MAT4, glm::value_ptr(value), sizeof(glm::mat4))) {
+        glProgramUniformMatrix4fv(ID, uniformLocations[handle.index], 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+void ShaderStage::setVec3(UniformHandle handle, const glm::vec3 &value) const
+{
+    if (updateShadow(handle, GL_FLOAT_VEC3, glm::value_ptr(value), sizeof(glm::vec3))) {
+        glProgramUniform3fv(ID, uniformLocations[handle.index], 1, glm::value_ptr(value));
+    }
+}
+
+ShaderStage &getShaderStage(GLenum type, const std::string &path, const std::vector<std::string> &defines, ShaderStage::COMPILE_MODE mode) {
+    // Drop the defines this stage never looks at, they would only cause duplicate compiles
+    std::vector<std::string> files;
+    const std::string source = preprocessShader(path, {}, files);
+    std::vector<std::string> stageDefines;
+    std::string key = std::to_string(type) + path;
+    for (const std::string &define : defines) {
+        const std::string name = define.substr(0, define.find(' '));
+        if (mentionsName(source, name)) {
+            stageDefines.push_back(define);
+            key += "\n" + define;
+        }
+    }
+
+    std::unique_ptr<ShaderStage> &stage = stageCache()[key];
+    if (!stage) {
+        stage = std::make_unique<ShaderStage>(type, path, mode, stageDefines);
+    } else if (mode == ShaderStage::IMMEDIATE && !stage->isReady()) {
+        stage->waitUntilReady();
+    }
+    return *stage;
+}
+
+int reloadShaderStages(const std::string &path) {
+    int reloaded = 0;
+    for (auto &entry : stageCache()) {
+        if (entry.second->dependsOn(path)) {
+            entry.second->reload();
+            reloaded++;
+        }
+    }
+    return reloaded;
+}
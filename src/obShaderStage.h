@@ -0,0 +1,142 @@
+#ifndef OBSHADERSTAGE_H
+#define OBSHADERSTAGE_H
+
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// A pre-resolved uniform, obtained once through Shader::getUniform
+// The default handle refers to an empty slot, so setting it is a no-op
+struct UniformHandle {
+    int index = 0;
+};
+
+// A single shader stage compiled into its own separable program
+// Stages are shared through getShaderStage, so each path + defines combination is compiled once
+// and a Shader combines a vertex and a fragment stage into a program pipeline
+class ShaderStage {
+    public:
+        enum COMPILE_MODE {
+            IMMEDIATE, // Compile and link before returning
+            DEFERRED   // Submit the compile and return, poll isReady() before using the stage
+        };
+
+        // The separable program's ID, 0 until it has linked
+        unsigned int ID = 0;
+
+        // GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+        const GLenum type;
+
+        // Give the path relative to the /shaders directory
+        ShaderStage(GLenum type, const std::string path, COMPILE_MODE mode, const std::vector<std::string> defines);
+
+        ShaderStage(const ShaderStage &) = delete;
+        ShaderStage &operator=(const ShaderStage &) = delete;
+
+        // Whether a linked program is available, finishes a deferred build once the driver is done
+        bool isReady();
+
+        // Finish an in flight build right away, blocking until the driver or the shader worker is done
+        void waitUntilReady();
+
+        // Counts the programs swapped in so far, changes every time ID does
+        unsigned int getGeneration() const;
+
+        // Whether the stage is built from the given file (relative to the /shaders directory), includes count too
+        bool dependsOn(const std::string &path) const;
+
+        // Recompile from the current sources in the background
+        // The new program replaces ID only once it has linked, a failed build keeps the old one
+        void reload();
+
+        // Resolve a uniform name into a slot, names the program doesn't have yet still get one
+        // so a reload that adds the uniform picks up the value set through it
+        UniformHandle getUniform(const std::string &name);
+
+        // Values are shadowed per stage, setting a uniform to the value it already has issues no GL call
+        // Uploads go through glProgramUniform* so the stage doesn't have to be bound
+        void setInt(UniformHandle handle, int value) const;
+        void setFloat(UniformHandle handle, float value) const;
+        void setMat4(UniformHandle handle, const glm::mat4 &value) const;
+        void setVec3(UniformHandle handle, const glm::vec3 &value) const;
+
+        // Uniform uploads sent to GL and skipped as unchanged, summed over every stage
+        struct UploadStats {
+            unsigned int issued = 0;
+            unsigned int skipped = 0;
+        };
+
+        // Counts since the last reset, e.g. reset at the start of each frame to get per-frame numbers
+        static UploadStats getUploadStats();
+        static void resetUploadStats();
+
+    private:
+        // Source file relative to the /shaders directory
+        std::string path;
+        std::vector<std::string> defines;
+
+        // Every file the last build read, including #includes
+        std::vector<std::string> dependencies;
+
+        // State of a compile that may still be in flight on the driver or the shader worker
+        struct Build;
+        std::shared_ptr<Build> pendingBuild;
+
+        bool ready = false;
+        bool reloadQueued = false;
+        unsigned int generation = 0;
+
+        // Create the program and kick off compiling and linking without waiting on any results
+        static void startBuild(Build &build);
+
+        // Wait for the results, report errors and cache the binary of a successful link
+        static void finishBuild(Build &build);
+
+        // Load the source and start building a new program
+        void submitBuild(COMPILE_MODE mode);
+
+        // Take over a finished build's program if it linked
+        void completeBuild();
+
+        // Uniform locations indexed by UniformHandle::index, slot 0 is always -1
+        std::vector<GLint> uniformLocations;
+
+        // Uniform names to their slot in uniformLocations
+        std::unordered_map<std::string, int> uniformSlots;
+
+        // Last value set through each slot, type is 0 until the slot has been set
+        struct UniformShadow {
+            GLenum type = 0;
+            alignas(float) unsigned char value[sizeof(float) * 16];
+        };
+        mutable std::vector<UniformShadow> uniformShadows;
+
+        static UploadStats uploadStats;
+
+        // Record value in the slot's shadow, returns false if the upload can be skipped
+        // because the value is unchanged or the program has no such uniform
+        bool updateShadow(UniformHandle handle, GLenum type, const void* value, std::size_t size) const;
+
+        // Upload every shadowed value into a freshly linked program
+        void restoreUniforms();
+
+        // Enumerate the linked program's active uniforms into the location table
+        void introspectUniforms();
+
+        // Attach the shared uniform blocks the program uses to their fixed binding points
+        void bindUniformBlocks();
+};
+
+// Get the shared stage for a file, compiling it the first time it is asked for
+// Only the defines the stage's source mentions are part of its identity, so e.g. a fragment
+// feature doesn't cause another compile of the vertex stage
+// An IMMEDIATE request for a stage that is still compiling waits for it to finish
+ShaderStage &getShaderStage(GLenum type, const std::string &path, const std::vector<std::string> &defines, ShaderStage::COMPILE_MODE mode);
+
+// Reload every cached stage built from the given file, returns how many were reloaded
+int reloadShaderStages(const std::string &path);
+
+#endif
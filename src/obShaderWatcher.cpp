@@ -0,0 +1,123 @@
+#include "obShaderWatcher.h"
+#include "obShader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+    // Only shader sources trigger reloads, editors also touch swap and backup files
+    bool isShaderFile(const std::filesystem::path &path) {
+        const std::string extension = path.extension().string();
+        return extension == ".vert" || extension == ".frag" || extension == ".glsl";
+    }
+}
+
+ShaderWatcher::ShaderWatcher(const std::string directory) : directory(directory) {
+    if (directory.empty()) {
+        return;
+    }
+#ifdef __linux__
+    inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFD == -1) {
+        std::cerr << "ERROR::SHADER_WATCHER::INOTIFY_INIT_FAILED -> " << std::strerror(errno) << std::endl;
+        return;
+    }
+    // Editors either rewrite the file in place or rename a new file over it
+    if (inotify_add_watch(inotifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        std::cerr << "ERROR::SHADER_WATCHER::WATCH_FAILED --> " << directory << " -> " << std::strerror(errno) << std::endl;
+    }
+#else
+    collectChanges();
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+    if (inotifyFD != -1) {
+        close(inotifyFD);
+    }
+#endif
+}
+
+void ShaderWatcher::watch(Shader &shader) {
+    shaders.push_back(&shader);
+}
+
+void ShaderWatcher::update() {
+    // Stages are shared between shaders, reload each affected stage once rather than once per shader
+    for (const std::string &file : collectChanges()) {
+        const bool watched = std::any_of(shaders.begin(), shaders.end(), [&file](const Shader* shader) {
+            return shader->dependsOn(file);
+        });
+        if (watched) {
+            std::cout << "SHADER_WATCHER::RELOADING --> " << file << std::endl;
+            reloadShaderStages(file);
+        }
+    }
+
+    // Swap in any stages that finished compiling since the last frame
+    for (Shader* shader : shaders) {
+        shader->isReady();
+    }
+}
+
+std::vector<std::string> ShaderWatcher::collectChanges() {
+    std::vector<std::string> changed;
+
+#ifdef __linux__
+    if (inotifyFD == -1) {
+        return changed;
+    }
+
+    // Drain every queued event without blocking
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(inotifyFD, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        for (char* cursor = buffer; cursor < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+            if (event->len > 0 && isShaderFile(event->name)) {
+                changed.push_back(std::string("/") + event->name);
+            }
+            cursor += sizeof(inotify_event) + event->len;
+        }
+    }
+#else
+    const auto now = std::chrono::steady_clock::now();
+    if (directory.empty() || now - lastPoll < pollInterval) {
+        return changed;
+    }
+    lastPoll = now;
+
+    std::error_code error;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!isShaderFile(entry.path())) {
+            continue;
+        }
+        const std::string name = "/" + entry.path().filename().string();
+        const std::filesystem::file_time_type modified = entry.last_write_time(error);
+        auto known = modifiedTimes.find(name);
+        if (known == modifiedTimes.end()) {
+            modifiedTimes.emplace(name, modified);
+        } else if (known->second != modified) {
+            known->second = modified;
+            changed.push_back(name);
+        }
+    }
+#endif
+
+    // A single save can produce several events
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
@@ -0,0 +1,48 @@
+#ifndef OBSHADERWATCHER_H
+#define OBSHADERWATCHER_H
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Shader;
+
+// Watches the shader directory and reloads the shaders built from files that change (includes too)
+// Uses inotify on Linux and falls back to polling modification times elsewhere
+class ShaderWatcher {
+    public:
+        // Start watching a directory, shaders name their files relative to it
+        // An empty directory watches nothing, e.g. when shaders are embedded in the executable
+        ShaderWatcher(const std::string directory);
+        ~ShaderWatcher();
+
+        ShaderWatcher(const ShaderWatcher &) = delete;
+        ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+        // Reload this shader whenever one of its files changes
+        void watch(Shader &shader);
+
+        // Call once per frame: reloads shaders whose files changed and swaps in finished programs
+        // Never waits on the compiler, a reload becomes visible on a later frame
+        void update();
+
+    private:
+        std::filesystem::path directory;
+        std::vector<Shader*> shaders;
+
+        // Names ("/file.frag") of the files that changed since the last call
+        std::vector<std::string> collectChanges();
+
+#ifdef __linux__
+        int inotifyFD = -1;
+#else
+        // Last seen modification times, checked every pollInterval
+        std::unordered_map<std::string, std::filesystem::file_time_type> modifiedTimes;
+        std::chrono::steady_clock::time_point lastPoll;
+        const std::chrono::milliseconds pollInterval{250};
+#endif
+};
+
+#endif
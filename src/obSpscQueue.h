@@ -0,0 +1,46 @@
+#ifndef OBSPSCQUEUE_H
+#define OBSPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed size lock-free queue between exactly one producer thread and one consumer thread
+// CAPACITY must be a power of two, the queue holds at most CAPACITY items
+template <typename T, std::size_t CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    public:
+        // Producer: append an item, returns false (dropping it) when the queue is full
+        bool push(const T &item) {
+            const std::size_t tail = writeIndex.load(std::memory_order_relaxed);
+            if (tail - readIndex.load(std::memory_order_acquire) == CAPACITY) {
+                return false;
+            }
+            items[tail & (CAPACITY - 1)] = item;
+            writeIndex.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: the oldest item, or nullptr when the queue is empty
+        const T* front() const {
+            const std::size_t head = readIndex.load(std::memory_order_relaxed);
+            if (head == writeIndex.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return &items[head & (CAPACITY - 1)];
+        }
+
+        // Consumer: remove the item front() returned
+        void pop() {
+            readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        // On separate cache lines so the two threads don't keep stealing each other's line
+        alignas(64) std::atomic<std::size_t> readIndex{0};
+        alignas(64) std::atomic<std::size_t> writeIndex{0};
+        T items[CAPACITY];
+};
+
+#endif
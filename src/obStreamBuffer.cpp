@@ -0,0 +1,149 @@
+#include "obStreamBuffer.h"
+#include "obGLState.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Target used to create and fill the buffer, so it doesn't disturb the bindings draws rely on
+    const GLenum WRITE_TARGET = GL_COPY_WRITE_BUFFER;
+
+    // Give up waiting on a fence after this long and write anyway, something else has gone wrong by then
+    const GLuint64 FENCE_TIMEOUT_NANOSECONDS = 1000000000;
+
+    // Regions are sized in multiples of this, so an offset aligned within a region is aligned in the buffer
+    // Covers GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT on the hardware we run on
+    const std::size_t REGION_ALIGNMENT = 256;
+
+    std::size_t roundUpRegion(std::size_t size) {
+        return std::max<std::size_t>((size + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT, 1) * REGION_ALIGNMENT;
+    }
+}
+
+StreamBuffer::StreamBuffer(std::size_t bytesPerFrame) : regionSize(roundUpRegion(bytesPerFrame)) {
+#ifndef IS_MACOS
+    persistent = GLAD_GL_VERSION_4_4 != 0;
+#endif
+    createStorage();
+}
+
+StreamBuffer::~StreamBuffer() {
+    destroyStorage();
+}
+
+void StreamBuffer::createStorage() {
+    glGenBuffers(1, &ID);
+    GLState::bindBuffer(WRITE_TARGET, ID);
+    const GLsizeiptr totalSize = static_cast<GLsizeiptr>(regionSize * FRAMES_IN_FLIGHT);
+#ifndef IS_MACOS
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(WRITE_TARGET, totalSize, NULL, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(WRITE_TARGET, 0, totalSize, flags));
+        if (mapped) {
+            return;
+        }
+        std::cerr << "ERROR::STREAM_BUFFER::MAP_FAILED --> falling back to staged writes" << std::endl;
+        persistent = false;
+        // Immutable storage can't be mapped the other way either, start over with a mutable buffer
+        GLState::deleteBuffers(1, &ID);
+        glGenBuffers(1, &ID);
+        GLState::bindBuffer(WRITE_TARGET, ID);
+    }
+#endif
+    glBufferData(WRITE_TARGET, totalSize, NULL, GL_STREAM_DRAW);
+    staging.resize(regionSize);
+    mapped = staging.data();
+}
+
+void StreamBuffer::destroyStorage() {
+    for (GLsync &fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (persistent) {
+        GLState::bindBuffer(WRITE_TARGET, ID);
+        glUnmapBuffer(WRITE_TARGET);
+    }
+    mapped = nullptr;
+    // GL keeps the storage alive until draws already issued from it are done
+    GLState::deleteBuffers(1, &ID);
+    ID = 0;
+}
+
+void StreamBuffer::beginFrame(std::size_t bytesNeeded) {
+    if (bytesNeeded > regionSize) {
+        destroyStorage();
+        regionSize = roundUpRegion(std::max(bytesNeeded, regionSize * 2));
+        createStorage();
+        region = FRAMES_IN_FLIGHT - 1;
+    }
+    region = (region + 1) % FRAMES_IN_FLIGHT;
+    used = 0;
+    flushed = 0;
+
+    GLsync &fence = fences[region];
+    if (!fence) {
+        return;
+    }
+    // Only count it as a stall if the GPU wasn't already done
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        stalls++;
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NANOSECONDS);
+    }
+    if (result == GL_WAIT_FAILED || result == GL_TIMEOUT_EXPIRED) {
+        std::cerr << "ERROR::STREAM_BUFFER::FENCE --> region " << region << " may still be in use" << std::endl;
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void* StreamBuffer::allocate(std::size_t size, std::size_t alignment, std::size_t &offset) {
+    const std::size_t start = alignment > 1 ? (used + alignment - 1) / alignment * alignment : used;
+    if (start + size > regionSize) {
+        return nullptr;
+    }
+    used = start + size;
+    offset = region * regionSize + start;
+    // The staging copy only holds the current region
+    return persistent ? mapped + offset : mapped + start;
+}
+
+void StreamBuffer::flush() {
+    if (persistent || flushed == used) {
+        return;
+    }
+    // The fence already guarantees the GPU is done with this range, so skip the implicit sync
+    GLState::bindBuffer(WRITE_TARGET, ID);
+    const GLintptr offset = static_cast<GLintptr>(region * regionSize + flushed);
+    const GLsizeiptr size = static_cast<GLsizeiptr>(used - flushed);
+    void* destination = glMapBufferRange(WRITE_TARGET, offset, size,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (destination) {
+        std::memcpy(destination, staging.data() + flushed, size);
+        glUnmapBuffer(WRITE_TARGET);
+    } else {
+        std::cerr << "ERROR::STREAM_BUFFER::MAP_FAILED --> " << size << " bytes weren't uploaded" << std::endl;
+    }
+    flushed = used;
+}
+
+void StreamBuffer::endFrame() {
+    flush();
+    if (fences[region]) {
+        glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool StreamBuffer::isPersistent() const {
+    return persistent;
+}
+
+unsigned int StreamBuffer::getStallCount() const {
+    return stalls;
+}
@@ -0,0 +1,70 @@
+#ifndef OBSTREAMBUFFER_H
+#define OBSTREAMBUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+// A buffer for data rewritten every frame, split into one region per frame in flight
+// The CPU fills this frame's region while the GPU still reads the previous ones, and a fence placed
+// after each frame's draws says when its region can be written again, so there is no orphaning or implicit sync
+// With GL 4.4 the buffer is persistently and coherently mapped (glBufferStorage) and written in place
+// Without it (macOS is GL 4.1) writes are staged and copied in by flush() through an unsynchronized mapping
+class StreamBuffer {
+    public:
+        static constexpr int FRAMES_IN_FLIGHT = 3;
+
+        // The buffer, bind it to whatever target reads the data
+        unsigned int ID = 0;
+
+        // bytesPerFrame is the starting size of each region, see beginFrame() for growing it
+        explicit StreamBuffer(std::size_t bytesPerFrame);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer &) = delete;
+        StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+        // Move on to the next region, waiting for the GPU if it hasn't finished the frame that last used it
+        // If bytesNeeded doesn't fit a region the buffer is replaced by a larger one, which changes ID
+        void beginFrame(std::size_t bytesNeeded = 0);
+
+        // Reserve size bytes of this frame's region, offset receives where they start in the buffer
+        // Returns nullptr if the region is full, pass the frame's total to beginFrame() to avoid that
+        // Write the data, then flush() before drawing with it
+        void* allocate(std::size_t size, std::size_t alignment, std::size_t &offset);
+
+        // Make what was written since the last flush visible to GL, a no-op when mapped persistently
+        void flush();
+
+        // Fence the region once every draw reading from it has been issued
+        void endFrame();
+
+        // Whether writes go straight into a persistent mapping
+        bool isPersistent() const;
+
+        // Times beginFrame() had to wait on the GPU, a steady climb means the GPU is the bottleneck
+        unsigned int getStallCount() const;
+
+    private:
+        bool persistent = false;
+        std::size_t regionSize = 0;
+
+        // Base of the persistent mapping, or of the staging copy
+        unsigned char* mapped = nullptr;
+        std::vector<unsigned char> staging;
+
+        int region = FRAMES_IN_FLIGHT - 1;
+        GLsync fences[FRAMES_IN_FLIGHT] = {};
+
+        // Bytes of the current region handed out, and how many of them flush() already copied
+        std::size_t used = 0;
+        std::size_t flushed = 0;
+
+        unsigned int stalls = 0;
+
+        // (Re)create the buffer with room for FRAMES_IN_FLIGHT regions of regionSize
+        void createStorage();
+        void destroyStorage();
+};
+
+#endif
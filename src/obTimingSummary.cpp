@@ -0,0 +1,27 @@
+#include "obTimingSummary.h"
+
+#include <algorithm>
+#include <cmath>
+
+TimingSummary summarizeTimes(std::vector<float> samples) {
+    TimingSummary summary;
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (float sample : samples) {
+        total += sample;
+    }
+    auto percentile = [&](float fraction) {
+        const std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * samples.size()));
+        return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+    };
+    summary.mean = static_cast<float>(total / samples.size());
+    summary.min = samples.front();
+    summary.median = percentile(0.5f);
+    summary.p95 = percentile(0.95f);
+    summary.p99 = percentile(0.99f);
+    summary.max = samples.back();
+    return summary;
+}
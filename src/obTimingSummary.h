@@ -0,0 +1,19 @@
+#ifndef OBTIMINGSUMMARY_H
+#define OBTIMINGSUMMARY_H
+
+#include <vector>
+
+// Summary of a series of times in milliseconds
+struct TimingSummary {
+    float mean = 0.0f;
+    float min = 0.0f;
+    float median = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+// Summarize samples, percentiles pick the nearest sample rank, all zero when there are no samples
+TimingSummary summarizeTimes(std::vector<float> samples);
+
+#endif
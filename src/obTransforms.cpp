@@ -0,0 +1,347 @@
+#include "obTransforms.h"
+#include "obCpu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#ifdef OB_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+    // glm::mat4 is 16 contiguous floats, column by column
+    const float* elements(const glm::mat4 &matrix) {
+        return &matrix[0][0];
+    }
+
+    float* elements(glm::mat4 &matrix) {
+        return &matrix[0][0];
+    }
+
+    void transformBoxesScalar(const glm::mat4* matrices, const BoundingBoxes &local, BoundingBoxes &world, std::size_t begin) {
+        for (std::size_t i = begin; i < local.size(); i++) {
+            // Transform the center, and project the extents onto the absolute axes for the new extents
+            const glm::mat4 &m = matrices[i];
+            const glm::vec3 center = glm::vec3(local.minX[i] + local.maxX[i], local.minY[i] + local.maxY[i], local.minZ[i] + local.maxZ[i]) * 0.5f;
+            const glm::vec3 extent = glm::vec3(local.maxX[i] - local.minX[i], local.maxY[i] - local.minY[i], local.maxZ[i] - local.minZ[i]) * 0.5f;
+            const glm::vec3 worldCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+            const glm::vec3 worldExtent = glm::abs(glm::vec3(m[0])) * extent.x + glm::abs(glm::vec3(m[1])) * extent.y + glm::abs(glm::vec3(m[2])) * extent.z;
+            world.set(static_cast<std::uint32_t>(i), worldCenter - worldExtent, worldCenter + worldExtent);
+        }
+    }
+
+#ifndef OB_X86
+    void multiplyPairsScalar(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            out[i] = lhs[i] * rhs[i];
+        }
+    }
+
+    void multiplyBroadcastScalar(const glm::mat4 &lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+        const glm::mat4 left = lhs;
+        for (std::size_t i = 0; i < count; i++) {
+            out[i] = left * rhs[i];
+        }
+    }
+#else
+    // SSE2 is part of every x86-64 CPU, so these need no runtime check
+
+    // Each result column is the left columns weighted by one right column's elements
+    // Both operands are fully loaded before the store, which is what lets out alias them
+    void multiplySSE(const __m128 (&left)[4], const float* right, float* result) {
+        __m128 columns[4];
+        for (int c = 0; c < 4; c++) {
+            const __m128 r = _mm_loadu_ps(right + c * 4);
+            __m128 column = _mm_mul_ps(left[0], _mm_shuffle_ps(r, r, 0x00));
+            column = _mm_add_ps(column, _mm_mul_ps(left[1], _mm_shuffle_ps(r, r, 0x55)));
+            column = _mm_add_ps(column, _mm_mul_ps(left[2], _mm_shuffle_ps(r, r, 0xAA)));
+            column = _mm_add_ps(column, _mm_mul_ps(left[3], _mm_shuffle_ps(r, r, 0xFF)));
+            columns[c] = column;
+        }
+        for (int c = 0; c < 4; c++) {
+            _mm_storeu_ps(result + c * 4, columns[c]);
+        }
+    }
+
+    void multiplyPairsSSE(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            const float* l = elements(lhs[i]);
+            const __m128 left[4] = {_mm_loadu_ps(l), _mm_loadu_ps(l + 4), _mm_loadu_ps(l + 8), _mm_loadu_ps(l + 12)};
+            multiplySSE(left, elements(rhs[i]), elements(out[i]));
+        }
+    }
+
+    void multiplyBroadcastSSE(const glm::mat4 &lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+        const float* l = elements(lhs);
+        const __m128 left[4] = {_mm_loadu_ps(l), _mm_loadu_ps(l + 4), _mm_loadu_ps(l + 8), _mm_loadu_ps(l + 12)};
+        for (std::size_t i = 0; i < count; i++) {
+            multiplySSE(left, elements(rhs[i]), elements(out[i]));
+        }
+    }
+
+    void transformBoxesSSE(const glm::mat4* matrices, const BoundingBoxes &local, BoundingBoxes &world) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (std::size_t i = 0; i < local.size(); i++) {
+            const float* m = elements(matrices[i]);
+            const __m128 column0 = _mm_loadu_ps(m);
+            const __m128 column1 = _mm_loadu_ps(m + 4);
+            const __m128 column2 = _mm_loadu_ps(m + 8);
+            const __m128 column3 = _mm_loadu_ps(m + 12);
+
+            const __m128 minimum = _mm_setr_ps(local.minX[i], local.minY[i], local.minZ[i], 0.0f);
+            const __m128 maximum = _mm_setr_ps(local.maxX[i], local.maxY[i], local.maxZ[i], 0.0f);
+            const __m128 center = _mm_mul_ps(_mm_add_ps(minimum, maximum), half);
+            const __m128 extent = _mm_mul_ps(_mm_sub_ps(maximum, minimum), half);
+
+            __m128 worldCenter = _mm_add_ps(column3, _mm_mul_ps(column0, _mm_shuffle_ps(center, center, 0x00)));
+            worldCenter = _mm_add_ps(worldCenter, _mm_mul_ps(column1, _mm_shuffle_ps(center, center, 0x55)));
+            worldCenter = _mm_add_ps(worldCenter, _mm_mul_ps(column2, _mm_shuffle_ps(center, center, 0xAA)));
+            __m128 worldExtent = _mm_mul_ps(_mm_andnot_ps(signMask, column0), _mm_shuffle_ps(extent, extent, 0x00));
+            worldExtent = _mm_add_ps(worldExtent, _mm_mul_ps(_mm_andnot_ps(signMask, column1), _mm_shuffle_ps(extent, extent, 0x55)));
+            worldExtent = _mm_add_ps(worldExtent, _mm_mul_ps(_mm_andnot_ps(signMask, column2), _mm_shuffle_ps(extent, extent, 0xAA)));
+
+            alignas(16) float worldMin[4];
+            alignas(16) float worldMax[4];
+            _mm_store_ps(worldMin, _mm_sub_ps(worldCenter, worldExtent));
+            _mm_store_ps(worldMax, _mm_add_ps(worldCenter, worldExtent));
+            world.minX[i] = worldMin[0];
+            world.minY[i] = worldMin[1];
+            world.minZ[i] = worldMin[2];
+            world.maxX[i] = worldMax[0];
+            world.maxY[i] = worldMax[1];
+            world.maxZ[i] = worldMax[2];
+        }
+    }
+
+    // AVX2 computes two result columns per instruction, the left matrix is repeated in both
+    // 128 bit lanes and each lane broadcasts the elements of its own right column
+    OB_TARGET_AVX2 void multiplyAVX2(const __m256 (&left)[4], const float* right, float* result) {
+        const __m256 right01 = _mm256_loadu_ps(right);
+        const __m256 right23 = _mm256_loadu_ps(right + 8);
+        __m256 columns01 = _mm256_mul_ps(left[0], _mm256_shuffle_ps(right01, right01, 0x00));
+        columns01 = _mm256_fmadd_ps(left[1], _mm256_shuffle_ps(right01, right01, 0x55), columns01);
+        columns01 = _mm256_fmadd_ps(left[2], _mm256_shuffle_ps(right01, right01, 0xAA), columns01);
+        columns01 = _mm256_fmadd_ps(left[3], _mm256_shuffle_ps(right01, right01, 0xFF), columns01);
+        __m256 columns23 = _mm256_mul_ps(left[0], _mm256_shuffle_ps(right23, right23, 0x00));
+        columns23 = _mm256_fmadd_ps(left[1], _mm256_shuffle_ps(right23, right23, 0x55), columns23);
+        columns23 = _mm256_fmadd_ps(left[2], _mm256_shuffle_ps(right23, right23, 0xAA), columns23);
+        columns23 = _mm256_fmadd_ps(left[3], _mm256_shuffle_ps(right23, right23, 0xFF), columns23);
+        _mm256_storeu_ps(result, columns01);
+        _mm256_storeu_ps(result + 8, columns23);
+    }
+
+    OB_TARGET_AVX2 void multiplyPairsAVX2(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            const float* l = elements(lhs[i]);
+            const __m256 left[4] = {_mm256_broadcast_ps(reinterpret_cast<const __m128*>(l)), _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 4)),
+                                    _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 8)), _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 12))};
+            multiplyAVX2(left, elements(rhs[i]), elements(out[i]));
+        }
+    }
+
+    OB_TARGET_AVX2 void multiplyBroadcastAVX2(const glm::mat4 &lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+        const float* l = elements(lhs);
+        const __m256 left[4] = {_mm256_broadcast_ps(reinterpret_cast<const __m128*>(l)), _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 4)),
+                                _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 8)), _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 12))};
+        for (std::size_t i = 0; i < count; i++) {
+            multiplyAVX2(left, elements(rhs[i]), elements(out[i]));
+        }
+    }
+
+    // Boxes are already a structure of arrays, so 8 are transformed at once with the
+    // matrix elements gathered from 8 consecutive matrices
+    OB_TARGET_AVX2 void transformBoxesAVX2(const glm::mat4* matrices, const BoundingBoxes &local, BoundingBoxes &world) {
+        const std::size_t batches = local.size() / 8 * 8;
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256i stride = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+        for (std::size_t i = 0; i < batches; i += 8) {
+            const float* m = elements(matrices[i]);
+            // Columns by rows, the bottom row of an affine matrix isn't needed
+            __m256 element[4][3];
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 3; row++) {
+                    element[column][row] = _mm256_i32gather_ps(m + column * 4 + row, stride, 4);
+                }
+            }
+
+            const __m256 minX = _mm256_loadu_ps(&local.minX[i]);
+            const __m256 minY = _mm256_loadu_ps(&local.minY[i]);
+            const __m256 minZ = _mm256_loadu_ps(&local.minZ[i]);
+            const __m256 maxX = _mm256_loadu_ps(&local.maxX[i]);
+            const __m256 maxY = _mm256_loadu_ps(&local.maxY[i]);
+            const __m256 maxZ = _mm256_loadu_ps(&local.maxZ[i]);
+            const __m256 centerX = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+            const __m256 centerY = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+            const __m256 centerZ = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+            const __m256 extentX = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+            const __m256 extentY = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+            const __m256 extentZ = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+            float* worldMin[3] = {&world.minX[i], &world.minY[i], &world.minZ[i]};
+            float* worldMax[3] = {&world.maxX[i], &world.maxY[i], &world.maxZ[i]};
+            for (int row = 0; row < 3; row++) {
+                __m256 worldCenter = _mm256_fmadd_ps(element[0][row], centerX, element[3][row]);
+                worldCenter = _mm256_fmadd_ps(element[1][row], centerY, worldCenter);
+                worldCenter = _mm256_fmadd_ps(element[2][row], centerZ, worldCenter);
+                __m256 worldExtent = _mm256_mul_ps(_mm256_andnot_ps(signMask, element[0][row]), extentX);
+                worldExtent = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, element[1][row]), extentY, worldExtent);
+                worldExtent = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, element[2][row]), extentZ, worldExtent);
+                _mm256_storeu_ps(worldMin[row], _mm256_sub_ps(worldCenter, worldExtent));
+                _mm256_storeu_ps(worldMax[row], _mm256_add_ps(worldCenter, worldExtent));
+            }
+        }
+        transformBoxesScalar(matrices, local, world, batches);
+    }
+
+    bool useAVX2() {
+        return getCpuFeatures().avx2 && getCpuFeatures().fma;
+    }
+#endif
+
+    void resizeBoxes(BoundingBoxes &boxes, std::size_t size) {
+        boxes.minX.resize(size);
+        boxes.minY.resize(size);
+        boxes.minZ.resize(size);
+        boxes.maxX.resize(size);
+        boxes.maxY.resize(size);
+        boxes.maxZ.resize(size);
+    }
+
+    // Average microseconds per call of work over a few repetitions
+    template <typename Work>
+    double timeMicroseconds(Work work) {
+        const int REPETITIONS = 20;
+        work();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REPETITIONS; i++) {
+            work();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / REPETITIONS;
+    }
+
+    float largestDifference(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b) {
+        float difference = 0.0f;
+        for (std::size_t i = 0; i < a.size(); i++) {
+            for (int e = 0; e < 16; e++) {
+                difference = std::max(difference, std::fabs(elements(a[i])[e] - elements(b[i])[e]));
+            }
+        }
+        return difference;
+    }
+
+    float largestDifference(const BoundingBoxes &a, const BoundingBoxes &b) {
+        float difference = 0.0f;
+        for (std::size_t i = 0; i < a.size(); i++) {
+            difference = std::max({difference, std::fabs(a.minX[i] - b.minX[i]), std::fabs(a.minY[i] - b.minY[i]), std::fabs(a.minZ[i] - b.minZ[i]),
+                                   std::fabs(a.maxX[i] - b.maxX[i]), std::fabs(a.maxY[i] - b.maxY[i]), std::fabs(a.maxZ[i] - b.maxZ[i])});
+        }
+        return difference;
+    }
+
+    void printResult(const char* name, double glmMicroseconds, double batchMicroseconds, float difference) {
+        std::cout << name << ": glm " << glmMicroseconds << " us, batch " << batchMicroseconds << " us ("
+                  << glmMicroseconds / batchMicroseconds << "x), largest difference " << difference << std::endl;
+    }
+}
+
+void multiplyMatrices(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+#ifdef OB_X86
+    if (useAVX2()) {
+        multiplyPairsAVX2(lhs, rhs, out, count);
+    } else {
+        multiplyPairsSSE(lhs, rhs, out, count);
+    }
+#else
+    multiplyPairsScalar(lhs, rhs, out, count);
+#endif
+}
+
+void multiplyMatrices(const glm::mat4 &lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count) {
+#ifdef OB_X86
+    if (useAVX2()) {
+        multiplyBroadcastAVX2(lhs, rhs, out, count);
+    } else {
+        multiplyBroadcastSSE(lhs, rhs, out, count);
+    }
+#else
+    multiplyBroadcastScalar(lhs, rhs, out, count);
+#endif
+}
+
+void transformBoxes(const glm::mat4* matrices, const BoundingBoxes &local, BoundingBoxes &world) {
+    resizeBoxes(world, local.size());
+#ifdef OB_X86
+    if (useAVX2()) {
+        transformBoxesAVX2(matrices, local, world);
+    } else {
+        transformBoxesSSE(matrices, local, world);
+    }
+#else
+    transformBoxesScalar(matrices, local, world, 0);
+#endif
+}
+
+void benchmarkTransforms(std::size_t count) {
+#ifdef OB_X86
+    const char* kernel = useAVX2() ? "AVX2" : "SSE2";
+#else
+    const char* kernel = "scalar";
+#endif
+    std::cout << "Transform benchmark, " << count << " objects, " << kernel << " kernels" << std::endl;
+
+    // Random but fixed scene, a parent and a local transform per object
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28318f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+    std::vector<glm::mat4> parents(count);
+    std::vector<glm::mat4> locals(count);
+    BoundingBoxes localBoxes;
+    for (std::size_t i = 0; i < count; i++) {
+        parents[i] = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random))),
+                                 angle(random), glm::vec3(0.0f, 1.0f, 0.0f));
+        locals[i] = glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(position(random), 0.0f, position(random)) * 0.05f),
+                                           angle(random), glm::vec3(1.0f, 0.3f, 0.5f)), glm::vec3(size(random)));
+        const glm::vec3 extent(size(random), size(random), size(random));
+        localBoxes.add(-extent, extent);
+    }
+    const glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+                                     glm::lookAt(glm::vec3(0.0f, 10.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::vector<glm::mat4> world(count);
+    std::vector<glm::mat4> glmResult(count);
+    const double glmCompose = timeMicroseconds([&] {
+        for (std::size_t i = 0; i < count; i++) {
+            glmResult[i] = parents[i] * locals[i];
+        }
+    });
+    const double batchCompose = timeMicroseconds([&] { multiplyMatrices(parents.data(), locals.data(), world.data(), count); });
+    printResult("local -> world", glmCompose, batchCompose, largestDifference(glmResult, world));
+
+    std::vector<glm::mat4> clip(count);
+    const double glmClip = timeMicroseconds([&] {
+        for (std::size_t i = 0; i < count; i++) {
+            glmResult[i] = viewProjection * world[i];
+        }
+    });
+    const double batchClip = timeMicroseconds([&] { multiplyMatrices(viewProjection, world.data(), clip.data(), count); });
+    printResult("world -> clip", glmClip, batchClip, largestDifference(glmResult, clip));
+
+    BoundingBoxes glmBoxes;
+    BoundingBoxes worldBoxes;
+    const double glmTransformBoxes = timeMicroseconds([&] {
+        // The same center and extents method written with glm
+        resizeBoxes(glmBoxes, count);
+        transformBoxesScalar(world.data(), localBoxes, glmBoxes, 0);
+    });
+    const double batchTransformBoxes = timeMicroseconds([&] { transformBoxes(world.data(), localBoxes, worldBoxes); });
+    printResult("bounding boxes", glmTransformBoxes, batchTransformBoxes, largestDifference(glmBoxes, worldBoxes));
+}
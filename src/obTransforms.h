@@ -0,0 +1,26 @@
+#ifndef OBTRANSFORMS_H
+#define OBTRANSFORMS_H
+
+#include "obCulling.h"
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Batch 4x4 matrix math for updating the transforms of many objects at once
+// Every function picks the widest kernel the CPU supports at runtime (AVX2, SSE2, then scalar)
+// Matrices are in glm's column major layout, out may be the same array as an input
+
+// out[i] = lhs[i] * rhs[i], e.g. parent world matrices times local matrices to compose local -> world
+void multiplyMatrices(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count);
+
+// out[i] = lhs * rhs[i], e.g. the view projection times world matrices for world -> clip
+void multiplyMatrices(const glm::mat4 &lhs, const glm::mat4* rhs, glm::mat4* out, std::size_t count);
+
+// Replace world with the axis aligned boxes enclosing each local box transformed by matrices[i]
+// The matrices must be affine, i.e. no projection
+void transformBoxes(const glm::mat4* matrices, const BoundingBoxes &local, BoundingBoxes &world);
+
+// Time every kernel against the equivalent glm loop over count objects and print the results
+void benchmarkTransforms(std::size_t count);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef OBUNIFORMBLOCKS_H
+#define OBUNIFORMBLOCKS_H
+
+// Uniform blocks shared between programs and the fixed binding points they are attached to
+// Shader connects every block it finds by name when a program links (GLSL 330 has no layout(binding))
+
+constexpr unsigned int FRAME_BLOCK_BINDING = 0;
+constexpr unsigned int MATERIAL_BLOCK_BINDING = 1;
+
+struct UniformBlockBinding {
+    const char* name;
+    unsigned int binding;
+};
+
+constexpr UniformBlockBinding UNIFORM_BLOCK_BINDINGS[] = {
+    {"FrameData", FRAME_BLOCK_BINDING},      // shaders/frame.glsl, obFrameUniforms.h
+    {"MaterialData", MATERIAL_BLOCK_BINDING} // shaders/materials.glsl, obMaterials.h
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "obViewSet.h"
+
+std::size_t ViewSet::addView(Camera &camera) {
+    cameras.push_back(&camera);
+    return cameras.size() - 1;
+}
+
+void ViewSet::clear() {
+    cameras.clear();
+    frustums.clear();
+    visibility = ViewVisibility();
+}
+
+std::size_t ViewSet::getViewCount() const {
+    return cameras.size();
+}
+
+Camera &ViewSet::getCamera(std::size_t view) {
+    return *cameras[view];
+}
+
+void ViewSet::gatherFrustums() {
+    frustums.resize(cameras.size());
+    for (std::size_t view = 0; view < cameras.size(); view++) {
+        frustums[view] = cameras[view]->getFrustum();
+    }
+}
+
+void ViewSet::cullSpheres(const BoundingSpheres &spheres) {
+    gatherFrustums();
+    frustumCullSpheres(frustums, spheres, visibility);
+}
+
+void ViewSet::cullBoxes(const BoundingBoxes &boxes) {
+    gatherFrustums();
+    frustumCullBoxes(frustums, boxes, visibility);
+}
+
+const ViewVisibility &ViewSet::getVisibility() const {
+    return visibility;
+}
+
+bool ViewSet::isVisible(std::size_t view, std::size_t object) const {
+    return visibility.isVisible(view, object);
+}
+
+void ViewSet::collectVisible(std::size_t view, std::vector<std::uint32_t> &visible) const {
+    visibility.collect(view, visible);
+}
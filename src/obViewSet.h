@@ -0,0 +1,46 @@
+#ifndef OBVIEWSET_H
+#define OBVIEWSET_H
+
+#include "obCamera.h"
+#include "obCulling.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A group of cameras that share one scene traversal, e.g. the main view plus shadow cascades,
+// split screen players or reflection and probe views
+// Culling walks the object bounds once for all of them instead of once per view
+class ViewSet {
+    public:
+        // Add a camera as the next view and return its index, the camera has to outlive the set
+        std::size_t addView(Camera &camera);
+
+        // Remove every view
+        void clear();
+
+        std::size_t getViewCount() const;
+        Camera &getCamera(std::size_t view);
+
+        // Cull the volumes against every view's frustum in a single pass
+        void cullSpheres(const BoundingSpheres &spheres);
+        void cullBoxes(const BoundingBoxes &boxes);
+
+        // Results of the last cull
+        const ViewVisibility &getVisibility() const;
+        bool isVisible(std::size_t view, std::size_t object) const;
+
+        // Replace visible with the indices of the objects the view can see
+        void collectVisible(std::size_t view, std::vector<std::uint32_t> &visible) const;
+
+    private:
+        std::vector<Camera*> cameras;
+
+        // Gathered from the cameras on every cull, they are cached there so this is a copy
+        std::vector<Frustum> frustums;
+        ViewVisibility visibility;
+
+        void gatherFrustums();
+};
+
+#endif